@@ -0,0 +1,237 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * On-device benchmarks, built as the `mv-iot-device-demo-bench` target
+ * in place of the application. Each workload is timed with the DWT
+ * cycle counter over a window of samples. The fastest of several runs
+ * is logged, as that run was least disturbed by interrupts. Build once
+ * with ENABLE_HARDWARE_FPU set to 1 and once with it set to 0 to
+ * compare the hardware and software float paths.
+ *
+ * The sensor conversions are timed both as the drivers now make them,
+ * in integer fixed point, and as they used to, in double precision.
+ */
+
+
+/*
+ * CONSTANTS
+ */
+#define     BENCH_WINDOW_SIZE           256
+#define     BENCH_RUNS                  8
+#define     BENCH_PERIOD_MS             10000
+
+// The range the old accelerometer conversion scaled by, in G
+#define     BENCH_ACCEL_RANGE_G         2
+
+#if ENABLE_HARDWARE_FPU == 1
+#define     BENCH_FLOAT_ABI             "hard float"
+#else
+#define     BENCH_FLOAT_ABI             "soft float"
+#endif
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    const char*     name;
+    void            (*run)(void);
+} BenchWorkload;        // Record for a workload: `run` processes the whole window
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void     bench_fill_window(void);
+static void     bench_run_all(void);
+static void     bench_biquad_float(void);
+static void     bench_biquad_double(void);
+static void     bench_accel_fixed(void);
+static void     bench_accel_double(void);
+static void     bench_temp_fixed(void);
+static void     bench_temp_double(void);
+
+
+/*
+ * GLOBALS
+ */
+// The I2C driver links against these, but the benchmarks don't use the bus
+I2C_HandleTypeDef i2c;
+bool use_i2c = false;
+
+// Raw accelerometer counts at ±2G: about 1G on the axis,
+// with a slow swing and a little noise
+static int16_t window[BENCH_WINDOW_SIZE];
+
+// Raw MCP9808 readings, in 1/16°C, around 22°C
+static int16_t temps[BENCH_WINDOW_SIZE];
+
+// Workload results are stored here so the work can't be optimized away
+static volatile float sink_float = 0.0f;
+static volatile double sink_double = 0.0;
+static volatile int32_t sink_int = 0;
+
+static const BenchWorkload workloads[] = {
+    { "biquad, float",  bench_biquad_float },
+    { "biquad, double", bench_biquad_double },
+    { "accel to mG, fixed point", bench_accel_fixed },
+    { "accel to G, double (old)", bench_accel_double },
+    { "temp to display, fixed point", bench_temp_fixed },
+    { "temp to display, double (old)", bench_temp_double }
+};
+
+
+/**
+ * @brief The benchmark entry point.
+ */
+int main(void) {
+    
+    HAL_Init();
+    SystemCoreClockUpdate();
+    HAL_InitTick(TICK_INT_PRIORITY);
+    
+    if (!cycles_init()) {
+        server_error("No DWT cycle counter, so no benchmarks");
+        while (true) HAL_Delay(BENCH_PERIOD_MS);
+    }
+    
+    bench_fill_window();
+    
+    // Repeat, so the results reach the log once it connects
+    while (true) {
+        bench_run_all();
+        HAL_Delay(BENCH_PERIOD_MS);
+    }
+}
+
+
+/**
+ * @brief Get the MV clock value.
+ *
+ * @returns The clock value.
+ */
+uint32_t SECURE_SystemCoreClockUpdate() {
+    
+    uint32_t clock = 0;
+    mvGetHClk(&clock);
+    return clock;
+}
+
+
+/**
+ * @brief Fill the sample window, without any float math.
+ */
+static void bench_fill_window(void) {
+    
+    uint32_t noise = 0x2545F491;
+    for (uint32_t i = 0 ; i < BENCH_WINDOW_SIZE ; ++i) {
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        
+        // A triangle wave of ±1024 counts over the window
+        int32_t phase = (int32_t)(i % 64);
+        int32_t swing = (phase < 32 ? phase : 64 - phase) * 64 - 1024;
+        window[i] = (int16_t)(16384 + swing + (int32_t)(noise & 0xFF) - 128);
+        temps[i] = (int16_t)(22 * 16 + (int32_t)((noise >> 8) & 0x1F) - 16);
+    }
+}
+
+
+/**
+ * @brief Time every workload and log its cycles per sample.
+ */
+static void bench_run_all(void) {
+    
+    for (uint32_t i = 0 ; i < sizeof(workloads) / sizeof(workloads[0]) ; ++i) {
+        uint32_t best = UINT32_MAX;
+        for (uint32_t run = 0 ; run < BENCH_RUNS ; ++run) {
+            uint32_t start = cycles_now();
+            workloads[i].run();
+            uint32_t cycles = cycles_now() - start;
+            if (cycles < best) best = cycles;
+        }
+        
+        server_log("Bench (%s) %s: %lu cycles per sample, %lu us per window",
+                   BENCH_FLOAT_ABI, workloads[i].name, best / BENCH_WINDOW_SIZE, cycles_to_us(best));
+    }
+}
+
+
+/*
+ * The workloads
+ */
+
+// The motion stream's low-pass, as `filter_chain_apply()` runs it
+static void bench_biquad_float(void) {
+    
+    BiquadCascade filter;
+    filter_biquad_init(&filter, filter_lowpass_tenth, FILTER_LOWPASS_STAGES);
+    float output = 0.0f;
+    for (uint32_t i = 0 ; i < BENCH_WINDOW_SIZE ; ++i) output = filter_biquad_apply(&filter, (float)window[i]);
+    sink_float = output;
+}
+
+// The same low-pass in double precision, which always runs in software
+// as the FPU is single precision. The cascade starts from zero, so it
+// does the same work per sample as the float one once primed
+static void bench_biquad_double(void) {
+    
+    double state[FILTER_LOWPASS_STAGES][2] = { { 0.0 } };
+    double output = 0.0;
+    for (uint32_t i = 0 ; i < BENCH_WINDOW_SIZE ; ++i) {
+        double value = (double)window[i];
+        for (uint32_t j = 0 ; j < FILTER_LOWPASS_STAGES ; ++j) {
+            const BiquadCoeffs* c = &filter_lowpass_tenth[j];
+            double* s = state[j];
+            output = (double)c->b0 * value + s[0];
+            s[0] = (double)c->b1 * value - (double)c->a1 * output + s[1];
+            s[1] = (double)c->b2 * value - (double)c->a2 * output;
+            value = output;
+        }
+    }
+    
+    sink_double = output;
+}
+
+// The accelerometer conversion, as `LIS3DH_get_accel()` makes it
+static void bench_accel_fixed(void) {
+    
+    int32_t total = 0;
+    for (uint32_t i = 0 ; i < BENCH_WINDOW_SIZE ; ++i) total += LIS3DH_raw_to_mg(window[i]);
+    sink_int = total;
+}
+
+// The accelerometer conversion as it was made before fixed point
+static void bench_accel_double(void) {
+    
+    double total = 0.0;
+    for (uint32_t i = 0 ; i < BENCH_WINDOW_SIZE ; ++i) total += (window[i] / 32000.0) * BENCH_ACCEL_RANGE_G;
+    sink_double = total;
+}
+
+// The temperature, in hundredths of a degree for the display,
+// as the LED task makes it
+static void bench_temp_fixed(void) {
+    
+    int32_t total = 0;
+    for (uint32_t i = 0 ; i < BENCH_WINDOW_SIZE ; ++i) total += (uint16_t)(MCP9808_raw_to_millicelsius(temps[i]) / 10);
+    sink_int = total;
+}
+
+// The display temperature as it was made before fixed point
+static void bench_temp_double(void) {
+    
+    int32_t total = 0;
+    for (uint32_t i = 0 ; i < BENCH_WINDOW_SIZE ; ++i) total += (uint16_t)((temps[i] / 16.0) * 100);
+    sink_int = total;
+}
@@ -0,0 +1,105 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/**
+ * @brief Append a CBOR data item's head: its major type and argument.
+ *
+ * The argument is written in the fewest bytes that hold it, as
+ * RFC 8949 requires for preferred serialization.
+ *
+ * @param body:  A pointer to the builder.
+ * @param major: The item's major type, eg. CBOR_MAJOR_UINT.
+ * @param value: The argument: a value, a length or a count.
+ */
+void cbor_append_head(HttpBodyBuilder* body, uint8_t major, uint32_t value) {
+    
+    uint8_t head[5];
+    uint32_t length = 1;
+    
+    if (value < 24) {
+        head[0] = major | value;
+    } else if (value <= 0xFF) {
+        head[0] = major | 24;
+        head[1] = value;
+        length = 2;
+    } else if (value <= 0xFFFF) {
+        head[0] = major | 25;
+        head[1] = value >> 8;
+        head[2] = value;
+        length = 3;
+    } else {
+        head[0] = major | 26;
+        head[1] = value >> 24;
+        head[2] = value >> 16;
+        head[3] = value >> 8;
+        head[4] = value;
+        length = 5;
+    }
+    
+    http_body_append(body, head, length);
+}
+
+
+/**
+ * @brief Append an unsigned integer.
+ *
+ * @param body:  A pointer to the builder.
+ * @param value: The value to add.
+ */
+void cbor_append_uint(HttpBodyBuilder* body, uint32_t value) {
+    
+    cbor_append_head(body, CBOR_MAJOR_UINT, value);
+}
+
+
+/**
+ * @brief Append a signed integer.
+ *
+ * @param body:  A pointer to the builder.
+ * @param value: The value to add.
+ */
+void cbor_append_int(HttpBodyBuilder* body, int32_t value) {
+    
+    // Negative integers are encoded as -1 - n, which can't overflow
+    if (value < 0) {
+        cbor_append_head(body, CBOR_MAJOR_NEGINT, (uint32_t)(-1 - value));
+    } else {
+        cbor_append_head(body, CBOR_MAJOR_UINT, (uint32_t)value);
+    }
+}
+
+
+/**
+ * @brief Append a byte string.
+ *
+ * @param body:   A pointer to the builder.
+ * @param data:   The bytes to add.
+ * @param length: The number of bytes to add.
+ */
+void cbor_append_bytes(HttpBodyBuilder* body, const uint8_t* data, uint32_t length) {
+    
+    cbor_append_head(body, CBOR_MAJOR_BYTES, length);
+    http_body_append(body, data, length);
+}
+
+
+/**
+ * @brief Append a UTF-8 text string.
+ *
+ * @param body:   A pointer to the builder.
+ * @param text:   The string's bytes.
+ * @param length: The number of bytes in the string.
+ */
+void cbor_append_text(HttpBodyBuilder* body, const char* text, uint32_t length) {
+    
+    cbor_append_head(body, CBOR_MAJOR_TEXT, length);
+    http_body_append(body, text, length);
+}
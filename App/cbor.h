@@ -0,0 +1,53 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _CBOR_H_
+#define _CBOR_H_
+
+
+/*
+ * CONSTANTS
+ */
+// Major types, pre-shifted into the initial byte's top three bits
+#define     CBOR_MAJOR_UINT             0x00
+#define     CBOR_MAJOR_NEGINT           0x20
+#define     CBOR_MAJOR_BYTES            0x40
+#define     CBOR_MAJOR_TEXT             0x60
+#define     CBOR_MAJOR_ARRAY            0x80
+#define     CBOR_MAJOR_MAP              0xA0
+#define     CBOR_MAJOR_TAG              0xC0
+
+
+/*
+ * MACROS
+ */
+// Append a string literal as a text string, its length known at compile time
+#define     cbor_append_text_literal(body, text)    cbor_append_text((body), (text), sizeof(text) - 1)
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        cbor_append_head(HttpBodyBuilder* body, uint8_t major, uint32_t value);
+void        cbor_append_uint(HttpBodyBuilder* body, uint32_t value);
+void        cbor_append_int(HttpBodyBuilder* body, int32_t value);
+void        cbor_append_bytes(HttpBodyBuilder* body, const uint8_t* data, uint32_t length);
+void        cbor_append_text(HttpBodyBuilder* body, const char* text, uint32_t length);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _CBOR_H_
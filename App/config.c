@@ -0,0 +1,230 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void config_apply_value(const char* key, uint8_t type, const char* value, uint8_t depth, void* context);
+static bool config_parse_int(const char* value, long* result);
+static bool config_parse_milli(const char* value, uint32_t* milli);
+
+
+/*
+ * GLOBALS
+ */
+// The live settings. Tasks read these each time round their loops,
+// so changes take effect without a restart
+static DeviceConfig device_config = {
+    .sample_period_ms = SENSOR_READ_PERIOD_MS,
+    .batch_size = TELEMETRY_BATCH_SIZE,
+    .click_threshold_mg = 1100,
+    .brightness = CONFIG_MAX_BRIGHTNESS,
+    .feature_window_ms = FEATURES_WINDOW_MS,
+    .temp_filters = FILTER_STAGE_MEDIAN | FILTER_STAGE_EMA,
+    .accel_filters = 0
+};
+
+
+/**
+ * @brief Get the live settings.
+ *
+ * @returns A pointer to the settings.
+ */
+const DeviceConfig* config_get(void) {
+    
+    return &device_config;
+}
+
+
+/**
+ * @brief Begin parsing a settings update.
+ *
+ * Recognized members of the update's top-level JSON object are:
+ *   `sample_period_ms`  -- Temperature sampling period
+ *   `batch_size`        -- Readings per telemetry upload
+ *   `click_threshold`   -- LIS3DH tap threshold in Gs
+ *   `brightness`        -- Display brightness, 0-15
+ *   `feature_window_ms` -- Motion feature window length
+ *   `temp_filters`      -- Temperature filter stages, FILTER_STAGE_* ORed
+ *   `accel_filters`     -- Acceleration filter stages, FILTER_STAGE_* ORed
+ * Other members are ignored, as are out-of-range values and values
+ * too long for the parser to hold whole.
+ *
+ * @param update: A pointer to the update record, which may live on the stack.
+ */
+void config_update_begin(ConfigUpdate* update) {
+    
+    update->staged = device_config;
+    update->changes = 0;
+    json_init(&update->parser, config_apply_value, update);
+}
+
+
+/**
+ * @brief Pass the next chunk of a settings update to the parser.
+ *
+ * @param update: A pointer to the update record.
+ * @param data:   The chunk's bytes.
+ * @param length: The number of bytes in the chunk.
+ *
+ * @returns `false` if the update is not valid JSON, otherwise `true`.
+ */
+bool config_update_feed(ConfigUpdate* update, const uint8_t* data, uint32_t length) {
+    
+    return json_feed(&update->parser, data, length);
+}
+
+
+/**
+ * @brief Complete a settings update.
+ *
+ * The staged settings are only made live if the whole update parsed
+ * cleanly, so a truncated response can't leave them half changed.
+ *
+ * @param update: A pointer to the update record.
+ */
+void config_update_end(ConfigUpdate* update) {
+    
+    if (!json_finish(&update->parser)) {
+        server_log("Response body is not a settings update");
+        return;
+    }
+    
+    if (update->changes > 0) {
+        device_config = update->staged;
+        server_log("Settings updated (%lu changes)", update->changes);
+    }
+}
+
+
+/**
+ * @brief JSON value handler: stage a recognized setting.
+ *
+ * @param key:     The value's member name.
+ * @param type:    The value's JSON type.
+ * @param value:   The value as text.
+ * @param depth:   The value's nesting depth.
+ * @param context: A pointer to the update record.
+ */
+static void config_apply_value(const char* key, uint8_t type, const char* value, uint8_t depth, void* context) {
+    
+    ConfigUpdate* update = (ConfigUpdate*)context;
+    DeviceConfig* staged = &update->staged;
+    if (depth != 1 || type != JSON_TYPE_NUMBER) return;
+    
+    // A number cut short may still parse, but as a different value
+    if (update->parser.truncated) return;
+    
+    if (strcmp(key, "sample_period_ms") == 0) {
+        long period = 0;
+        if (config_parse_int(value, &period) && period >= CONFIG_MIN_SAMPLE_PERIOD_MS && period <= CONFIG_MAX_SAMPLE_PERIOD_MS) {
+            staged->sample_period_ms = (uint32_t)period;
+            update->changes++;
+        }
+    } else if (strcmp(key, "batch_size") == 0) {
+        long size = 0;
+        if (config_parse_int(value, &size) && size >= 1 && size <= TELEMETRY_MAX_BATCH_R) {
+            staged->batch_size = (uint32_t)size;
+            update->changes++;
+        }
+    } else if (strcmp(key, "click_threshold") == 0) {
+        uint32_t threshold = 0;
+        if (config_parse_milli(value, &threshold) && threshold > 0 && threshold <= CONFIG_MAX_CLICK_THRESHOLD_MG) {
+            staged->click_threshold_mg = threshold;
+            update->changes++;
+        }
+    } else if (strcmp(key, "brightness") == 0) {
+        long brightness = 0;
+        if (config_parse_int(value, &brightness) && brightness >= 0 && brightness <= CONFIG_MAX_BRIGHTNESS) {
+            staged->brightness = (uint8_t)brightness;
+            update->changes++;
+        }
+    } else if (strcmp(key, "feature_window_ms") == 0) {
+        long window = 0;
+        if (config_parse_int(value, &window) && window >= FEATURES_MIN_WINDOW_MS && window <= FEATURES_MAX_WINDOW_MS) {
+            staged->feature_window_ms = (uint32_t)window;
+            update->changes++;
+        }
+    } else if (strcmp(key, "temp_filters") == 0) {
+        long stages = 0;
+        if (config_parse_int(value, &stages) && stages >= 0 && stages <= FILTER_STAGE_ALL) {
+            staged->temp_filters = (uint8_t)stages;
+            update->changes++;
+        }
+    } else if (strcmp(key, "accel_filters") == 0) {
+        long stages = 0;
+        if (config_parse_int(value, &stages) && stages >= 0 && stages <= FILTER_STAGE_ALL) {
+            staged->accel_filters = (uint8_t)stages;
+            update->changes++;
+        }
+    }
+}
+
+
+/**
+ * @brief Parse a decimal integer.
+ *
+ * The whole value must be an integer: fractions and exponents, such
+ * as "1.9" or "1e3", fail the parse rather than being cut short, as
+ * do values too large to hold.
+ *
+ * @param value:  The number's JSON text.
+ * @param result: Set to the value.
+ *
+ * @returns `true` if the value was parsed, otherwise `false`.
+ */
+static bool config_parse_int(const char* value, long* result) {
+    
+    char* end = NULL;
+    errno = 0;
+    long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || errno == ERANGE) return false;
+    *result = parsed;
+    return true;
+}
+
+
+/**
+ * @brief Parse a non-negative decimal number into thousandths.
+ *
+ * For example, "1.1" yields 1100. Digits past the third decimal place
+ * are ignored. Exponents are not supported, so they fail the parse,
+ * as do values too large to hold.
+ *
+ * @param value: The number's JSON text.
+ * @param milli: Set to the value multiplied by 1000.
+ *
+ * @returns `true` if the value was parsed, otherwise `false`.
+ */
+static bool config_parse_milli(const char* value, uint32_t* milli) {
+    
+    uint32_t result = 0;
+    const char* next = value;
+    while (*next >= '0' && *next <= '9') {
+        if (result > (UINT32_MAX / 1000 - 9) / 10) return false;
+        result = result * 10 + (*next++ - '0');
+    }
+    
+    if (next == value) return false;
+    result *= 1000;
+    
+    if (*next == '.') {
+        next++;
+        for (uint32_t scale = 100 ; *next >= '0' && *next <= '9' ; next++) {
+            result += (*next - '0') * scale;
+            scale /= 10;
+        }
+    }
+    
+    if (*next != '\0') return false;
+    *milli = result;
+    return true;
+}
@@ -0,0 +1,61 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _CONFIG_H_
+#define _CONFIG_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     CONFIG_MIN_SAMPLE_PERIOD_MS     1000
+#define     CONFIG_MAX_SAMPLE_PERIOD_MS     3600000
+#define     CONFIG_MAX_BRIGHTNESS           15
+#define     CONFIG_MAX_CLICK_THRESHOLD_MG   16000
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    sample_period_ms;
+    uint32_t    batch_size;
+    uint32_t    click_threshold_mg;
+    uint8_t     brightness;
+    uint32_t    feature_window_ms;
+    uint8_t     temp_filters;
+    uint8_t     accel_filters;
+} DeviceConfig;         // Record for settings the server can change
+
+typedef struct {
+    JsonParser      parser;
+    DeviceConfig    staged;
+    uint32_t        changes;
+} ConfigUpdate;         // Record for a settings update being parsed
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+const DeviceConfig* config_get(void);
+void                config_update_begin(ConfigUpdate* update);
+bool                config_update_feed(ConfigUpdate* update, const uint8_t* data, uint32_t length);
+void                config_update_end(ConfigUpdate* update);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _CONFIG_H_
@@ -0,0 +1,67 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * The Cortex-M33's DWT cycle counter, for timing code that takes
+ * less than the 1 ms HAL tick. The counter runs at the core clock,
+ * so it wraps after 2^32 cycles: about 27 s at 160 MHz. Only time
+ * spans shorter than that.
+ */
+
+
+/**
+ * @brief Start the cycle counter.
+ *
+ * Call after the core clock is set.
+ *
+ * @returns `true` if the counter is running, otherwise `false`,
+ *          eg. if the core has no counter.
+ */
+bool cycles_init(void) {
+    
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    
+    // Check that it counts
+    uint32_t start = DWT->CYCCNT;
+    __NOP();
+    __NOP();
+    __NOP();
+    __NOP();
+    return DWT->CYCCNT != start;
+}
+
+
+/**
+ * @brief Read the cycle counter.
+ *
+ * @returns The cycle count. Subtract an earlier count to get the
+ *          cycles between the two reads, even across a wrap.
+ */
+uint32_t cycles_now(void) {
+    
+    return DWT->CYCCNT;
+}
+
+
+/**
+ * @brief Convert a number of core clock cycles to microseconds.
+ *
+ * @param cycles: The number of cycles.
+ *
+ * @returns The time in µs.
+ */
+uint32_t cycles_to_us(uint32_t cycles) {
+    
+    uint32_t per_us = SystemCoreClock / 1000000;
+    return per_us > 0 ? cycles / per_us : 0;
+}
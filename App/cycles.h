@@ -0,0 +1,31 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _CYCLES_H_
+#define _CYCLES_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+bool        cycles_init(void);
+uint32_t    cycles_now(void);
+uint32_t    cycles_to_us(uint32_t cycles);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _CYCLES_H_
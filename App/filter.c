@@ -0,0 +1,220 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * GLOBALS
+ */
+// 4th-order Butterworth low-pass with its corner at a tenth of the sample
+// rate, as two biquads (Q 0.5412 and 1.3066, bilinear transform with
+// prewarping). Normalized to the sample rate, so one table serves any
+// stream: eg. 10Hz for the 100Hz motion stream
+const BiquadCoeffs filter_lowpass_tenth[FILTER_LOWPASS_STAGES] = {
+    { 0.061885195f, 0.123770391f, 0.061885195f, -1.048599576f, 0.296140358f },
+    { 0.077956341f, 0.155912681f, 0.077956341f, -1.320913431f, 0.632738793f }
+};
+
+
+/**
+ * @brief Set up a running median, eg. to remove single-sample spikes.
+ *
+ * @param filter: The filter.
+ * @param size:   The number of samples the median is taken over, up to
+ *                FILTER_MEDIAN_MAX_SIZE. Odd sizes give a true median.
+ */
+void filter_median_init(MedianFilter* filter, uint8_t size) {
+    
+    if (size == 0) size = 1;
+    if (size > FILTER_MEDIAN_MAX_SIZE) size = FILTER_MEDIAN_MAX_SIZE;
+    filter->size = size;
+    filter->count = 0;
+    filter->next = 0;
+}
+
+
+/**
+ * @brief Add a sample to a running median.
+ *
+ * Until the window fills, the median is of the samples so far.
+ *
+ * @param filter: The filter.
+ * @param value:  The sample.
+ *
+ * @returns The median of the window.
+ */
+float filter_median_apply(MedianFilter* filter, float value) {
+    
+    filter->window[filter->next] = value;
+    filter->next = (filter->next + 1) % filter->size;
+    if (filter->count < filter->size) filter->count++;
+    
+    // The window is small, so an insertion sort of a copy is quickest
+    float sorted[FILTER_MEDIAN_MAX_SIZE];
+    for (uint8_t i = 0 ; i < filter->count ; ++i) {
+        float item = filter->window[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > item) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        
+        sorted[j] = item;
+    }
+    
+    return sorted[filter->count >> 1];
+}
+
+
+/**
+ * @brief Set up a cascade of biquad sections.
+ *
+ * @param filter: The filter.
+ * @param coeffs: The sections' coefficients, which must outlive the filter.
+ * @param count:  The number of sections, up to FILTER_MAX_BIQUADS.
+ */
+void filter_biquad_init(BiquadCascade* filter, const BiquadCoeffs* coeffs, uint8_t count) {
+    
+    filter->coeffs = coeffs;
+    filter->count = count < FILTER_MAX_BIQUADS ? count : FILTER_MAX_BIQUADS;
+    filter->is_primed = false;
+}
+
+
+/**
+ * @brief Pass a sample through a cascade of biquad sections.
+ *
+ * Each section is in transposed direct form II. On the first sample the
+ * sections are primed as if that value had always been the input, so
+ * the output doesn't ramp up from zero: for the accelerometer, from 0G
+ * to 1G.
+ *
+ * @param filter: The filter.
+ * @param value:  The sample.
+ *
+ * @returns The filtered sample.
+ */
+float filter_biquad_apply(BiquadCascade* filter, float value) {
+    
+    for (uint8_t i = 0 ; i < filter->count ; ++i) {
+        const BiquadCoeffs* c = &filter->coeffs[i];
+        float* s = filter->state[i];
+        
+        if (!filter->is_primed) {
+            float output = value * (c->b0 + c->b1 + c->b2) / (1.0f + c->a1 + c->a2);
+            s[1] = c->b2 * value - c->a2 * output;
+            s[0] = c->b1 * value - c->a1 * output + s[1];
+        }
+        
+        float output = c->b0 * value + s[0];
+        s[0] = c->b1 * value - c->a1 * output + s[1];
+        s[1] = c->b2 * value - c->a2 * output;
+        value = output;
+    }
+    
+    filter->is_primed = true;
+    return value;
+}
+
+
+/**
+ * @brief Set up an exponential moving average.
+ *
+ * @param filter: The filter.
+ * @param alpha:  The weight of each new sample, 0 to 1. See FILTER_EMA_ALPHA().
+ */
+void filter_ema_init(EmaFilter* filter, float alpha) {
+    
+    filter->alpha = alpha;
+    filter->value = 0.0f;
+    filter->is_primed = false;
+}
+
+
+/**
+ * @brief Add a sample to an exponential moving average.
+ *
+ * The first sample starts the average.
+ *
+ * @param filter: The filter.
+ * @param value:  The sample.
+ *
+ * @returns The average.
+ */
+float filter_ema_apply(EmaFilter* filter, float value) {
+    
+    if (!filter->is_primed) {
+        filter->value = value;
+        filter->is_primed = true;
+    } else {
+        filter->value += filter->alpha * (value - filter->value);
+    }
+    
+    return filter->value;
+}
+
+
+/**
+ * @brief Set up a filter chain: a median, then a biquad cascade,
+ *        then a moving average, each of which can be switched off.
+ *
+ * The chain holds all of its state, so it needs no allocation.
+ *
+ * @param chain:        The chain.
+ * @param median_size:  The number of samples the median is taken over.
+ * @param coeffs:       The biquad sections' coefficients.
+ * @param biquad_count: The number of biquad sections.
+ * @param ema_alpha:    The moving average's smoothing factor.
+ * @param stages:       The stages to apply: FILTER_STAGE_MEDIAN, FILTER_STAGE_BIQUAD
+ *                      and FILTER_STAGE_EMA, ORed together.
+ */
+void filter_chain_init(FilterChain* chain, uint8_t median_size, const BiquadCoeffs* coeffs, uint8_t biquad_count, float ema_alpha, uint8_t stages) {
+    
+    filter_median_init(&chain->median, median_size);
+    filter_biquad_init(&chain->biquad, coeffs, biquad_count);
+    filter_ema_init(&chain->ema, ema_alpha);
+    chain->stages = stages & FILTER_STAGE_ALL;
+}
+
+
+/**
+ * @brief Switch a chain's stages on or off.
+ *
+ * Stages being switched on start afresh from the next sample,
+ * rather than from whatever they last saw.
+ *
+ * @param chain:  The chain.
+ * @param stages: The stages to apply -- see `filter_chain_init()`.
+ */
+void filter_chain_set_stages(FilterChain* chain, uint8_t stages) {
+    
+    stages &= FILTER_STAGE_ALL;
+    uint8_t added = stages & ~chain->stages;
+    if (added & FILTER_STAGE_MEDIAN) filter_median_init(&chain->median, chain->median.size);
+    if (added & FILTER_STAGE_BIQUAD) chain->biquad.is_primed = false;
+    if (added & FILTER_STAGE_EMA) chain->ema.is_primed = false;
+    chain->stages = stages;
+}
+
+
+/**
+ * @brief Pass a sample through a chain's enabled stages.
+ *
+ * @param chain: The chain.
+ * @param value: The sample.
+ *
+ * @returns The filtered sample.
+ */
+float filter_chain_apply(FilterChain* chain, float value) {
+    
+    if (chain->stages & FILTER_STAGE_MEDIAN) value = filter_median_apply(&chain->median, value);
+    if (chain->stages & FILTER_STAGE_BIQUAD) value = filter_biquad_apply(&chain->biquad, value);
+    if (chain->stages & FILTER_STAGE_EMA) value = filter_ema_apply(&chain->ema, value);
+    return value;
+}
@@ -0,0 +1,106 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _FILTER_H_
+#define _FILTER_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     FILTER_MAX_BIQUADS              4
+#define     FILTER_MEDIAN_MAX_SIZE          9             // NOTE Size in samples, not bytes
+
+// Filter chain stages, applied in this order
+#define     FILTER_STAGE_MEDIAN             0x01          // Despike
+#define     FILTER_STAGE_BIQUAD             0x02          // Low-pass
+#define     FILTER_STAGE_EMA                0x04          // Smooth
+#define     FILTER_STAGE_ALL                0x07
+
+#define     FILTER_LOWPASS_STAGES           2
+
+
+/*
+ * MACROS
+ */
+// The smoothing factor of an exponential moving average that spans
+// `span` samples, as a constant expression
+#define     FILTER_EMA_ALPHA(span)          (2.0f / ((float)(span) + 1.0f))
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    float       b0;
+    float       b1;
+    float       b2;
+    float       a1;
+    float       a2;
+} BiquadCoeffs;         // Record for a biquad section's coefficients, normalized so a0 is 1
+
+typedef struct {
+    const BiquadCoeffs* coeffs;
+    uint8_t             count;
+    bool                is_primed;
+    float               state[FILTER_MAX_BIQUADS][2];
+} BiquadCascade;        // Record for a cascade of biquad sections
+
+typedef struct {
+    float       alpha;
+    float       value;
+    bool        is_primed;
+} EmaFilter;            // Record for an exponential moving average
+
+typedef struct {
+    float       window[FILTER_MEDIAN_MAX_SIZE];
+    uint8_t     size;
+    uint8_t     count;
+    uint8_t     next;
+} MedianFilter;         // Record for a running median
+
+typedef struct {
+    uint8_t         stages;
+    MedianFilter    median;
+    BiquadCascade   biquad;
+    EmaFilter       ema;
+} FilterChain;          // Record for a chain of filters, any of which can be switched on or off
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * GLOBALS
+ */
+extern const BiquadCoeffs filter_lowpass_tenth[FILTER_LOWPASS_STAGES];
+
+
+/*
+ * PROTOTYPES
+ */
+void        filter_median_init(MedianFilter* filter, uint8_t size);
+float       filter_median_apply(MedianFilter* filter, float value);
+void        filter_biquad_init(BiquadCascade* filter, const BiquadCoeffs* coeffs, uint8_t count);
+float       filter_biquad_apply(BiquadCascade* filter, float value);
+void        filter_ema_init(EmaFilter* filter, float alpha);
+float       filter_ema_apply(EmaFilter* filter, float value);
+
+void        filter_chain_init(FilterChain* chain, uint8_t median_size, const BiquadCoeffs* coeffs, uint8_t biquad_count, float ema_alpha, uint8_t stages);
+void        filter_chain_set_stages(FilterChain* chain, uint8_t stages);
+float       filter_chain_apply(FilterChain* chain, float value);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _FILTER_H_
@@ -19,8 +19,6 @@ static void     HT16K33_write_cmd(uint8_t cmd);
 /*
  * GLOBALS
  */
-extern               I2C_HandleTypeDef    i2c;
-
 // The hex character set
 static const char    CHARSET[19] = "\x3F\x06\x5B\x4F\x66\x6D\x7D\x07\x7F\x6F\x5F\x7C\x58\x5E\x7B\x71\x40\x63";
 
@@ -45,6 +43,18 @@ void HT16K33_init(void) {
 }
 
 
+/**
+ * @brief Set the display brightness.
+ *
+ * @param brightness: The brightness, 0 (dimmest) to 15 (brightest).
+ */
+void HT16K33_set_brightness(uint8_t brightness) {
+    
+    if (brightness > 15) brightness = 15;
+    HT16K33_write_cmd(0xE0 | brightness);
+}
+
+
 /**
  * @brief Issue a single command byte to the HT16K33.
  *
@@ -52,7 +62,7 @@ void HT16K33_init(void) {
  */
 static void HT16K33_write_cmd(uint8_t cmd) {
     
-    HAL_I2C_Master_Transmit(&i2c, HT16K33_I2C_ADDR << 1, &cmd, 1, 100);
+    I2C_transfer(HT16K33_I2C_ADDR, &cmd, 1, NULL, 0, 100);
 }
 
 
@@ -72,13 +82,8 @@ void HT16K33_clear_buffer(void) {
  */
 void HT16K33_draw(void) {
     
-    // Set up the buffer holding the data to be
-    // transmitted to the LED
-    uint8_t tx_buffer[17] = { 0 };
-    memcpy(tx_buffer + 1, display_buffer, 16);
-
-    // Display the buffer and flash the LED
-    HAL_I2C_Master_Transmit(&i2c, HT16K33_I2C_ADDR << 1, tx_buffer, sizeof(tx_buffer), 100);
+    // Write the buffer to display RAM, from address 0
+    I2C_write_regs(HT16K33_I2C_ADDR, 0x00, display_buffer, 16, 100);
 }
 
 
@@ -26,6 +26,7 @@ extern "C" {
  */
 void        HT16K33_init(void);
 void        HT16K33_draw(void);
+void        HT16K33_set_brightness(uint8_t brightness);
 void        HT16K33_clear_buffer(void);
 void        HT16K33_show_value(int16_t value, bool has_decimal);
 void        HT16K33_set_alpha(char chr, uint8_t digit, bool has_dot);
@@ -9,6 +9,27 @@
 #include "main.h"
 
 
+/*
+ * STATIC PROTOTYPES
+ */
+static HttpRequestRecord*   http_reserve_record(uint8_t lane);
+static uint32_t             http_commit_record(uint8_t lane, HttpRequestRecord* record);
+static HttpRequestRecord*   http_lane_head(uint8_t lane);
+static bool                 http_alert_overdue(uint32_t tick);
+static void                 http_issue_next_request(uint8_t lane, uint32_t tick);
+static void                 http_pop_request(uint8_t lane, uint8_t outcome);
+static void                 http_retry_request(uint8_t lane, uint32_t tick, uint8_t outcome);
+static void                 http_log_lane_stats(void);
+static uint32_t             http_time_to_next_action(uint32_t tick);
+static uint32_t             http_time_until(uint32_t deadline, uint32_t tick);
+static uint32_t             http_backoff_ms(uint32_t attempts);
+static uint8_t              http_classify_status(enum MvStatus status);
+static uint8_t              http_process_response(void);
+static bool                 http_handle_body_chunk(const uint8_t* data, uint32_t length, uint32_t offset, void* context);
+static void                 http_push_event(uint8_t type, uint32_t tag);
+static bool                 http_pop_event(HttpEvent* event);
+
+
 /*
  *  GLOBALS
  */
@@ -25,9 +46,68 @@ struct {
 static volatile struct MvNotification http_notification_center[HTTP_NT_BUFFER_SIZE_R] __attribute__((aligned(8)));
 static volatile uint32_t current_notification_index = 0;
 
-// Defined in `main.c`
-extern volatile bool received_request;
-extern volatile bool channel_was_closed;
+// Channel events, queued by the notification ISR and consumed by
+// `http_service()`. There is one producer and one consumer, so
+// each index is written by only one side, and no lock is needed.
+// The indices run freely and are reduced modulo the queue size
+static volatile HttpEvent http_event_queue[HTTP_EVENT_QUEUE_SIZE_R];
+static volatile uint32_t event_head = 0;
+static volatile uint32_t event_tail = 0;
+static volatile HttpEventStats event_stats = { 0 };
+
+// The task woken by the ISR when it queues events
+static osThreadId_t consumer_task = NULL;
+
+_Static_assert((HTTP_EVENT_QUEUE_SIZE_R & (HTTP_EVENT_QUEUE_SIZE_R - 1)) == 0, "HTTP_EVENT_QUEUE_SIZE_R must be a power of two");
+
+// Outbound request queues, one per lane. When `request_in_flight` is
+// set, the record at the head of lane `in_flight_lane` is the one in
+// flight: it is only removed when its response has been read, so that
+// it can be re-issued if the channel drops before the response arrives
+static HttpRequestRecord alert_queue[HTTP_ALERT_QUEUE_SIZE_R];
+static HttpRequestRecord bulk_queue[HTTP_BULK_QUEUE_SIZE_R];
+
+static struct {
+    HttpRequestRecord*  records;
+    uint32_t            size;
+    uint32_t            head;
+    uint32_t            count;
+    uint32_t            waits;
+    uint64_t            total_wait_ms;
+    HttpLaneStats       stats;
+} http_lanes[HTTP_LANE_COUNT] = {
+    { .records = alert_queue, .size = HTTP_ALERT_QUEUE_SIZE_R },
+    { .records = bulk_queue,  .size = HTTP_BULK_QUEUE_SIZE_R }
+};
+
+static const char* const lane_names[HTTP_LANE_COUNT] = { "alert", "bulk" };
+
+static uint32_t next_request_seq = 1;
+static bool     request_in_flight = false;
+static uint8_t  in_flight_lane = HTTP_LANE_BULK;
+static uint32_t request_sent_tick = 0;
+static uint32_t last_activity_tick = 0;
+static uint32_t stats_tick = 0;
+
+// State for the retry jitter generator
+static uint32_t jitter_state = 0;
+
+// Request constants shared by every message we send
+static const char verb[] = "POST";
+static const char uri[] = API_URL;
+#if ENABLE_CBOR_BODIES == true
+static const char header_text[] = "Content-Type: application/cbor";
+#else
+static const char header_text[] = "Content-Type: application/json";
+#endif
+
+// Headers are built once, with their lengths fixed at compile time
+static const struct MvHttpHeader headers[] = {
+    { .data = (const uint8_t *)header_text, .length = sizeof(header_text) - 1 }
+};
+
+_Static_assert(sizeof(API_URL) < HTTP_TX_BUFFER_SIZE_B - HTTP_TX_OVERHEAD_B, "API_URL too long for the HTTP send buffer");
+
 
 /**
  * @brief Open a new HTTP channel.
@@ -37,8 +117,8 @@ extern volatile bool channel_was_closed;
 bool http_open_channel(void) {
     
     // Set up the HTTP channel's multi-use send and receive buffers
-    static volatile uint8_t http_rx_buffer[1536] __attribute__((aligned(512)));
-    static volatile uint8_t http_tx_buffer[512] __attribute__((aligned(512)));
+    static volatile uint8_t http_rx_buffer[HTTP_RX_BUFFER_SIZE_B] __attribute__((aligned(512)));
+    static volatile uint8_t http_tx_buffer[HTTP_TX_BUFFER_SIZE_B] __attribute__((aligned(512)));
 
     // Get the network channel handle.
     // NOTE This is set in `logging.c` which puts the network in place
@@ -68,8 +148,12 @@ bool http_open_channel(void) {
 
     // Ask Microvisor to open the channel
     // and confirm that it has accepted the request
+    // NOTE The call returns once the request is accepted, well within
+    //      the 1 ms tick, so it is timed with the cycle counter
+    uint32_t start_cycles = cycles_now();
     enum MvStatus status = mvOpenChannel(&channel_config, &http_handles.channel);
     if (status == MV_STATUS_OKAY) {
+        latency_record(LATENCY_STAGE_OPEN, cycles_to_us(cycles_now() - start_cycles));
         server_log("HTTP channel handle: %lu", (uint32_t)http_handles.channel);
         return true;
     }
@@ -89,23 +173,32 @@ void http_close_channel(void) {
     // the closure request.
     if (http_handles.channel != 0) {
         MvChannelHandle old = http_handles.channel;
+        uint32_t start_cycles = cycles_now();
         enum MvStatus status = mvCloseChannel(&http_handles.channel);
+        latency_record(LATENCY_STAGE_CLOSE, cycles_to_us(cycles_now() - start_cycles));
         if (status != MV_STATUS_OKAY && status != MV_STATUS_CHANNELCLOSED) report_and_assert(ERR_CHANNEL_NOT_CLOSED);
         server_log("HTTP channel %lu closed (status code: %i)", (uint32_t)old, status);
     }
 
     // Confirm the channel handle has been invalidated by Microvisor
     if (http_handles.channel != 0) report_and_assert(ERR_CHANNEL_HANDLE_NOT_ZERO);
+    
+    // Any events still queued came from the closed channel
+    event_head = event_tail;
 }
 
 
 /**
  * @brief Configure the channel Notification Center.
+ *
+ * Call this from the task that will call `http_service()`: the
+ * notification ISR wakes it by setting HTTP_EVENT_FLAG.
  */
 void http_notification_center_setup(void) {
     
     // Clear the notification store
     memset((void *)http_notification_center, 0xFF, sizeof(http_notification_center));
+    consumer_task = osThreadGetId();
 
     // Configure a notification center for network-centric notifications
     static struct MvNotificationSetup http_notification_setup = {
@@ -122,7 +215,9 @@ void http_notification_center_setup(void) {
         return;
     }
 
-    // Start the notification IRQ
+    // Start the notification IRQ. The ISR calls into the RTOS,
+    // so it can be no more urgent than the RTOS allows
+    HAL_NVIC_SetPriority(TIM8_BRK_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
     NVIC_ClearPendingIRQ(TIM8_BRK_IRQn);
     NVIC_EnableIRQ(TIM8_BRK_IRQn);
     server_log("HTTP NC handle: %lu", (uint32_t)http_handles.notification);
@@ -130,162 +225,1021 @@ void http_notification_center_setup(void) {
 
 
 /**
- * @brief Issue a warning message via HTTP.
+ * @brief Service the HTTP channel.
+ *
+ * Call this regularly from the task that owns the channel. It processes
+ * responses and disconnections flagged by the ISR, issues the next queued
+ * request when none is in flight, and closes the channel once it has been
+ * idle for HTTP_CHANNEL_IDLE_MS. The channel is otherwise kept open across
+ * requests so we only pay the set-up cost once per burst of traffic.
  *
- * @returns The request's MvStatus.
+ * Failed requests are retried with exponential backoff, until they succeed,
+ * fail permanently, run out of attempts or pass their deadline. This is the
+ * only place requests are issued, so a failing server costs one attempt per
+ * backoff period rather than a tight loop.
+ *
+ * Requests are taken from the alert lane ahead of the bulk lane. Microvisor
+ * carries one request per channel at a time, so an alert may find a bulk
+ * request in flight. It waits for that to complete, but not for longer than
+ * HTTP_ALERT_TARGET_MS: after that, the bulk request is abandoned by closing
+ * the channel, and re-sent after the alert without counting as an attempt.
+ *
+ * Every HTTP_STATS_PERIOD_MS, the lanes' counters and the per-stage
+ * latency histograms are summarized in the log.
+ *
+ * @returns The time in ms until the next call is due, unless a channel
+ *          event arrives first. Waiting for the network to come up isn't
+ *          timed, so callers should also poll at a period of their choosing.
  */
-enum MvStatus http_send_warning(void) {
+uint32_t http_service(void) {
     
-    // Check for a valid channel handle
-    if (http_handles.channel == 0) {
-        // There's no open channel, so open open one now and
-        // try to send again
-        http_open_channel();
-        return http_send_warning();
+    uint32_t tick = HAL_GetTick();
+    
+    // Handle every event the ISR has queued, in the order they arrived
+    HttpEvent event;
+    while (http_pop_event(&event)) {
+        if (event.type == HTTP_EVENT_CLOSED) {
+            // The channel was closed under us, so drop our handle and
+            // schedule a retry of any request that was in flight
+            http_close_channel();
+            
+            if (request_in_flight) {
+                server_error("HTTP channel lost with request %lu in flight", http_lane_head(in_flight_lane)->seq);
+                http_retry_request(in_flight_lane, tick, HTTP_OUTCOME_RETRY);
+            }
+        } else if (request_in_flight) {
+            // Process the response to the request in flight
+            // Responses take hundreds of ms, so the tick times them well enough
+            latency_record(LATENCY_STAGE_FIRST_BYTE, (event.tick - request_sent_tick) * 1000);
+            uint32_t start_cycles = cycles_now();
+            uint8_t outcome = http_process_response();
+            latency_record(LATENCY_STAGE_PROCESS, cycles_to_us(cycles_now() - start_cycles));
+            if (outcome == HTTP_OUTCOME_DELIVERED) {
+                http_pop_request(in_flight_lane, outcome);
+            } else {
+                http_retry_request(in_flight_lane, tick, outcome);
+            }
+        } else {
+            server_error("HTTP response received with no request in flight");
+        }
+        
+        last_activity_tick = tick;
+    }
+    
+    // Microvisor reports request time-outs as a failed response, so a request
+    // that outlives that is stuck on a channel that's no longer working
+    if (request_in_flight && tick - request_sent_tick > CHANNEL_KILL_PERIOD_MS) {
+        server_error("HTTP request %lu timed out", http_lane_head(in_flight_lane)->seq);
+        http_close_channel();
+        http_retry_request(in_flight_lane, tick, HTTP_OUTCOME_RETRY);
+        last_activity_tick = tick;
+    }
+    
+    // Has an alert been held up by a bulk request for too long?
+    if (request_in_flight && in_flight_lane != HTTP_LANE_ALERT && http_alert_overdue(tick)) {
+        server_error("HTTP request %lu preempted by an alert", http_lane_head(in_flight_lane)->seq);
+        http_lanes[in_flight_lane].stats.preempted++;
+        request_in_flight = false;
+        http_close_channel();
+        last_activity_tick = tick;
+    }
+    
+    if (!request_in_flight) {
+        // Issue the first ready request, taking the lanes in priority order
+        bool is_idle = true;
+        for (uint8_t lane = 0 ; lane < HTTP_LANE_COUNT && !request_in_flight ; ++lane) {
+            if (http_lanes[lane].count == 0) continue;
+            is_idle = false;
+            
+            HttpRequestRecord* record = http_lane_head(lane);
+            if (tick - record->queued_tick > HTTP_REQUEST_DEADLINE_MS) {
+                server_error("HTTP request %lu abandoned after %lu attempts", record->seq, record->attempts);
+                http_pop_request(lane, HTTP_OUTCOME_FAILED);
+            } else if ((int32_t)(tick - record->retry_tick) >= 0) {
+                // Requests wait in the queue while we're offline
+                if (http_handles.channel != 0 || net_is_connected()) http_issue_next_request(lane, tick);
+                break;
+            }
+        }
+        
+        if (is_idle && http_handles.channel != 0 && tick - last_activity_tick > HTTP_CHANNEL_IDLE_MS) {
+            server_log("HTTP channel idle");
+            http_close_channel();
+        }
     }
+    
+    if (tick - stats_tick > HTTP_STATS_PERIOD_MS) {
+        stats_tick = tick;
+        http_log_lane_stats();
+        latency_log_summary();
+        
+        HttpEventStats stats;
+        http_get_event_stats(&stats);
+        server_log("HTTP notifications: %lu read, %lu ignored, %lu ring full, %lu events dropped",
+                   stats.notifications, stats.ignored, stats.ring_full, stats.queue_overruns);
+    }
+    
+    return http_time_to_next_action(tick);
+}
 
-    server_log("Sending HTTP request");
 
-    static const char body[] = "{\"warning\":\"movement detected\"}";
+/**
+ * @brief Queue a warning message for sending via HTTP.
+ *
+ * @returns `true` if the message was queued, otherwise `false`.
+ */
+bool http_send_warning(void) {
+    
+    HttpBodyBuilder body;
+    if (!http_body_start(&body, HTTP_LANE_ALERT)) return false;
+    
+#if ENABLE_CBOR_BODIES == true
+    cbor_append_head(&body, CBOR_MAJOR_MAP, 1);
+    cbor_append_text_literal(&body, "warning");
+    cbor_append_text_literal(&body, "movement detected");
+#else
+    http_body_append_literal(&body, "{\"warning\":");
+    http_body_append_json_string(&body, "movement detected");
+    http_body_append_literal(&body, "}");
+#endif
+    return http_body_commit(&body) != 0;
+}
 
-    // Set up the request
-    static const char verb[] = "POST";
-    static const char uri[] = API_URL;
 
-    // Add a header
-    static const char header_text[] = "Content-Type: application/json";
-    struct MvHttpHeader header = {
-        .data = (uint8_t *)header_text,
-        .length = strlen(header_text)
-    };
+/**
+ * @brief Queue a batch of temperature readings for sending via HTTP.
+ *
+ * The readings are packed as a series of (tick, temperature) pairs.
+ * Each value is the zig-zag varint of its change from the previous
+ * reading's -- the first pair is sent whole -- and temperatures are the
+ * MCP9808's raw 1/16 degree Celsius steps, so the series decodes exactly.
+ * The packed bytes are posted as the `packed` member of a map: a byte
+ * string in CBOR, or base64 text in JSON.
+ *
+ * If the readings won't all fit in one request body, only the leading
+ * readings that do are queued.
+ *
+ * @param samples: An array of readings, oldest first.
+ * @param count:   The number of readings in the array.
+ * @param seq:     Set to the request's sequence number.
+ *
+ * @returns The number of readings queued -- 0 if none could be.
+ */
+uint32_t http_send_samples(const TelemetrySample* samples, uint32_t count, uint32_t* seq) {
+    
+    HttpBodyBuilder body;
+    if (!http_body_start(&body, HTTP_LANE_BULK)) return 0;
+    
+    // Work out how many packed bytes the body can carry
+#if ENABLE_CBOR_BODIES == true
+    cbor_append_head(&body, CBOR_MAJOR_MAP, 1);
+    cbor_append_text_literal(&body, "packed");
+    uint32_t space = http_body_space(&body) - 3;
+#else
+    http_body_append_literal(&body, "{\"packed\":\"");
+    uint32_t space = (http_body_space(&body) - 2) / 4 * 3;
+#endif
+    
+    uint8_t data[HTTP_MAX_BODY_LEN_B];
+    PackBuffer buffer;
+    pack_init(&buffer, data, space < sizeof(data) ? space : sizeof(data));
+    
+    int32_t last_tick = 0;
+    int32_t last_temp = 0;
+    uint32_t packed = 0;
+    for (packed = 0 ; packed < count ; ++packed) {
+        // Add the reading, but roll it back if it won't fit
+        uint32_t mark = buffer.length;
+        pack_delta(&buffer, (int32_t)samples[packed].tick, &last_tick);
+        pack_delta(&buffer, samples[packed].temp, &last_temp);
+        if (buffer.overflow) {
+            buffer.length = mark;
+            break;
+        }
+    }
+    
+    if (packed == 0) return 0;
+    
+#if ENABLE_CBOR_BODIES == true
+    cbor_append_bytes(&body, data, buffer.length);
+#else
+    http_body_append_base64(&body, data, buffer.length);
+    http_body_append_literal(&body, "\"}");
+#endif
+    *seq = http_body_commit(&body);
+    return *seq != 0 ? packed : 0;
+}
 
-    struct MvHttpHeader headers[] = { header };
+
+/**
+ * @brief Queue a window's motion features for sending via HTTP.
+ *
+ * The features are posted as the `motion` member of a map, itself a map
+ * holding the HAL tick when the window closed, the number of samples in
+ * it and, for each of the `x`, `y` and `z` axes, an array of integers:
+ * [mean mG, RMS mG, peak-to-peak mG, crest factor x100, zero-crossing
+ * rate in Hz x100]. That's around a hundred bytes for a window of
+ * thousands of samples.
+ *
+ * @param features: The window's features.
+ *
+ * @returns `true` if the features were queued, otherwise `false`.
+ */
+bool http_send_features(const MotionFeatures* features) {
+    
+    static const char* const axis_names[FEATURES_AXIS_COUNT] = { "x", "y", "z" };
+    
+    HttpBodyBuilder body;
+    if (!http_body_start(&body, HTTP_LANE_BULK)) return false;
+    
+#if ENABLE_CBOR_BODIES == true
+    cbor_append_head(&body, CBOR_MAJOR_MAP, 1);
+    cbor_append_text_literal(&body, "motion");
+    cbor_append_head(&body, CBOR_MAJOR_MAP, 2 + FEATURES_AXIS_COUNT);
+    cbor_append_text_literal(&body, "tick");
+    cbor_append_uint(&body, features->tick);
+    cbor_append_text_literal(&body, "samples");
+    cbor_append_uint(&body, features->samples);
+    
+    for (uint8_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) {
+        const AxisFeatures* axis = &features->axes[i];
+        cbor_append_text(&body, axis_names[i], 1);
+        cbor_append_head(&body, CBOR_MAJOR_ARRAY, 5);
+        cbor_append_int(&body, axis->mean_mg);
+        cbor_append_uint(&body, axis->rms_mg);
+        cbor_append_uint(&body, axis->peak_to_peak_mg);
+        cbor_append_uint(&body, axis->crest_factor);
+        cbor_append_uint(&body, axis->crossing_rate);
+    }
+#else
+    http_body_append_literal(&body, "{\"motion\":{\"tick\":");
+    http_body_append_uint(&body, features->tick);
+    http_body_append_literal(&body, ",\"samples\":");
+    http_body_append_uint(&body, features->samples);
+    
+    for (uint8_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) {
+        const AxisFeatures* axis = &features->axes[i];
+        http_body_append_literal(&body, ",");
+        http_body_append_json_string(&body, axis_names[i]);
+        http_body_append_literal(&body, ":[");
+        http_body_append_int(&body, axis->mean_mg);
+        http_body_append_literal(&body, ",");
+        http_body_append_uint(&body, axis->rms_mg);
+        http_body_append_literal(&body, ",");
+        http_body_append_uint(&body, axis->peak_to_peak_mg);
+        http_body_append_literal(&body, ",");
+        http_body_append_uint(&body, axis->crest_factor);
+        http_body_append_literal(&body, ",");
+        http_body_append_uint(&body, axis->crossing_rate);
+        http_body_append_literal(&body, "]");
+    }
+    
+    http_body_append_literal(&body, "}}");
+#endif
+    return http_body_commit(&body) != 0;
+}
+
+
+/**
+ * @brief Check whether a lane's request queue has space.
+ *
+ * @param lane: HTTP_LANE_ALERT or HTTP_LANE_BULK.
+ *
+ * @returns `true` if the queue is full, otherwise `false`.
+ */
+bool http_queue_full(uint8_t lane) {
+    
+    return http_lanes[lane].count == http_lanes[lane].size;
+}
+
+
+/**
+ * @brief Get the notification and event queue counters.
+ *
+ * @param data: Pointer to an HttpEventStats structure.
+ *              (see http.h)
+ */
+void http_get_event_stats(HttpEventStats* data) {
+    
+    // The ISR updates these, so take a consistent copy
+    __disable_irq();
+    *data = event_stats;
+    __enable_irq();
+}
+
+
+/**
+ * @brief Get a request lane's counters.
+ *
+ * Wait times run from a request being queued to its first transmission.
+ *
+ * @param lane: HTTP_LANE_ALERT or HTTP_LANE_BULK.
+ * @param data: Pointer to an HttpLaneStats structure.
+ *              (see http.h)
+ */
+void http_get_lane_stats(uint8_t lane, HttpLaneStats* data) {
+    
+    *data = http_lanes[lane].stats;
+    data->depth = http_lanes[lane].count;
+    data->mean_wait_ms = http_lanes[lane].waits > 0 ? (uint32_t)(http_lanes[lane].total_wait_ms / http_lanes[lane].waits) : 0;
+}
+
+
+/**
+ * @brief Begin a request body.
+ *
+ * This reserves the next record in the request queue, and the
+ * `http_body_append...()` calls then write directly into it, so
+ * there is no intermediate copy of the body. The record joins the
+ * queue only when it is passed to `http_body_commit()`; if that
+ * call isn't made, the record is simply reused by the next body.
+ *
+ * @param body: A pointer to the builder to initialize.
+ * @param lane: The lane to send the request in: HTTP_LANE_ALERT or HTTP_LANE_BULK.
+ *
+ * @returns `true` if a record was reserved, otherwise `false`.
+ */
+bool http_body_start(HttpBodyBuilder* body, uint8_t lane) {
+    
+    body->record = http_reserve_record(lane);
+    body->lane = lane;
+    body->length = 0;
+    body->overflow = false;
+    return body->record != NULL;
+}
+
+
+/**
+ * @brief Append raw bytes to a request body.
+ *
+ * Appends that won't fit set the builder's `overflow` flag,
+ * which causes `http_body_commit()` to reject the body.
+ *
+ * @param body:   A pointer to the builder.
+ * @param data:   The bytes to add.
+ * @param length: The number of bytes to add.
+ */
+void http_body_append(HttpBodyBuilder* body, const void* data, uint32_t length) {
+    
+    if (body->overflow || length > http_body_space(body)) {
+        body->overflow = true;
+        return;
+    }
+    
+    memcpy(&body->record->body[body->length], data, length);
+    body->length += length;
+}
+
+
+/**
+ * @brief Append an unsigned integer to a request body as decimal text.
+ *
+ * @param body:  A pointer to the builder.
+ * @param value: The value to add.
+ */
+void http_body_append_uint(HttpBodyBuilder* body, uint32_t value) {
+    
+    // Write the digits backwards from the end of a scratch
+    // buffer big enough for UINT32_MAX
+    char digits[10];
+    uint32_t index = sizeof(digits);
+    do {
+        digits[--index] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+    
+    http_body_append(body, &digits[index], sizeof(digits) - index);
+}
+
+
+/**
+ * @brief Append a signed integer to a request body as decimal text.
+ *
+ * @param body:  A pointer to the builder.
+ * @param value: The value to add.
+ */
+void http_body_append_int(HttpBodyBuilder* body, int32_t value) {
+    
+    if (value < 0) http_body_append_literal(body, "-");
+    http_body_append_uint(body, value < 0 ? -(uint32_t)value : (uint32_t)value);
+}
+
+
+/**
+ * @brief Append a string to a request body as a quoted JSON string.
+ *
+ * Quotes and backslashes are escaped; control characters are dropped.
+ *
+ * @param body:  A pointer to the builder.
+ * @param value: The NUL-terminated string to add.
+ */
+void http_body_append_json_string(HttpBodyBuilder* body, const char* value) {
+    
+    http_body_append_literal(body, "\"");
+    for (const char* next = value ; *next != 0 ; ++next) {
+        if (*next == '"' || *next == '\\') http_body_append_literal(body, "\\");
+        if ((uint8_t)*next >= 0x20) http_body_append(body, next, 1);
+    }
+    
+    http_body_append_literal(body, "\"");
+}
+
+
+/**
+ * @brief Append bytes to a request body as base64 text, with padding.
+ *
+ * @param body:   A pointer to the builder.
+ * @param data:   The bytes to encode.
+ * @param length: The number of bytes to encode.
+ */
+void http_body_append_base64(HttpBodyBuilder* body, const uint8_t* data, uint32_t length) {
+    
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    
+    for (uint32_t i = 0 ; i < length ; i += 3) {
+        // Take up to three bytes; a short final group is padded with '='
+        uint32_t group = data[i] << 16;
+        if (i + 1 < length) group |= data[i + 1] << 8;
+        if (i + 2 < length) group |= data[i + 2];
+        
+        char text[4] = {
+            alphabet[(group >> 18) & 0x3F],
+            alphabet[(group >> 12) & 0x3F],
+            i + 1 < length ? alphabet[(group >> 6) & 0x3F] : '=',
+            i + 2 < length ? alphabet[group & 0x3F] : '='
+        };
+        
+        http_body_append(body, text, 4);
+    }
+}
+
+
+/**
+ * @brief Get the space remaining in a request body.
+ *
+ * @param body: A pointer to the builder.
+ *
+ * @returns The number of bytes that can still be appended.
+ */
+uint32_t http_body_space(const HttpBodyBuilder* body) {
+    
+    return sizeof(body->record->body) - body->length;
+}
+
+
+/**
+ * @brief Queue a completed request body for sending.
+ *
+ * @param body: A pointer to the builder.
+ *
+ * @returns The request's sequence number, or 0 if it was not queued.
+ */
+uint32_t http_body_commit(HttpBodyBuilder* body) {
+    
+    if (body->record == NULL) return 0;
+    
+    if (body->overflow) {
+        server_error("HTTP request body too large");
+        return 0;
+    }
+    
+    body->record->body_length = body->length;
+    return http_commit_record(body->lane, body->record);
+}
+
+
+/**
+ * @brief Get the next free record in a lane's request queue.
+ *
+ * @param lane: The lane.
+ *
+ * @returns A pointer to the record, or `NULL` if the queue is full.
+ */
+static HttpRequestRecord* http_reserve_record(uint8_t lane) {
+    
+    if (http_queue_full(lane)) {
+        server_error("HTTP %s queue full", lane_names[lane]);
+        return NULL;
+    }
+    
+    return &http_lanes[lane].records[(http_lanes[lane].head + http_lanes[lane].count) % http_lanes[lane].size];
+}
+
+
+/**
+ * @brief Add a reserved and populated record to a lane's request queue.
+ *
+ * @param lane:   The lane the record was reserved in.
+ * @param record: A pointer to the record returned by `http_reserve_record()`.
+ *
+ * @returns The record's sequence number.
+ */
+static uint32_t http_commit_record(uint8_t lane, HttpRequestRecord* record) {
+    
+    // Sequence numbers are never 0, so it can flag failure
+    record->seq = next_request_seq++;
+    if (next_request_seq == 0) next_request_seq = 1;
+    record->queued_tick = HAL_GetTick();
+    record->retry_tick = record->queued_tick;
+    record->attempts = 0;
+    record->was_sent = false;
+    
+    HttpLaneStats* stats = &http_lanes[lane].stats;
+    http_lanes[lane].count++;
+    stats->queued++;
+    if (http_lanes[lane].count > stats->max_depth) stats->max_depth = http_lanes[lane].count;
+    server_log("HTTP request %lu queued (%lu pending in %s lane)", record->seq, http_lanes[lane].count, lane_names[lane]);
+    return record->seq;
+}
+
+
+/**
+ * @brief Get the record at the head of a lane's request queue.
+ *
+ * @param lane: The lane.
+ *
+ * @returns A pointer to the record. Only valid if the lane isn't empty.
+ */
+static HttpRequestRecord* http_lane_head(uint8_t lane) {
+    
+    return &http_lanes[lane].records[http_lanes[lane].head];
+}
+
+
+/**
+ * @brief Check whether the next alert has been ready to send
+ *        for longer than HTTP_ALERT_TARGET_MS.
+ *
+ * @param tick: The current HAL tick.
+ *
+ * @returns `true` if the alert is overdue, otherwise `false`.
+ */
+static bool http_alert_overdue(uint32_t tick) {
+    
+    if (http_lanes[HTTP_LANE_ALERT].count == 0) return false;
+    
+    // An alert waiting out a retry backoff isn't ready yet
+    HttpRequestRecord* record = http_lane_head(HTTP_LANE_ALERT);
+    return (int32_t)(tick - record->retry_tick) >= HTTP_ALERT_TARGET_MS;
+}
+
+
+/**
+ * @brief Remove the record at the head of a lane's request queue
+ *        and report its outcome to the telemetry store.
+ *
+ * @param lane:    The lane.
+ * @param outcome: HTTP_OUTCOME_DELIVERED, HTTP_OUTCOME_FAILED or HTTP_OUTCOME_REJECTED.
+ */
+static void http_pop_request(uint8_t lane, uint8_t outcome) {
+    
+    if (http_lanes[lane].count > 0) {
+        HttpLaneStats* stats = &http_lanes[lane].stats;
+        if (outcome == HTTP_OUTCOME_DELIVERED) stats->delivered++;
+        if (outcome == HTTP_OUTCOME_FAILED) stats->failed++;
+        if (outcome == HTTP_OUTCOME_REJECTED) stats->rejected++;
+        
+        telemetry_request_done(http_lane_head(lane)->seq, outcome);
+        http_lanes[lane].head = (http_lanes[lane].head + 1) % http_lanes[lane].size;
+        http_lanes[lane].count--;
+    }
+    
+    request_in_flight = false;
+}
+
+
+/**
+ * @brief Handle a failed attempt at the request at the head of the queue.
+ *
+ * Permanent failures are dropped at once. Transient ones are scheduled
+ * for another attempt after a backoff delay, unless the request has used
+ * up its HTTP_MAX_ATTEMPTS.
+ *
+ * @param lane:    The lane holding the request.
+ * @param tick:    The current HAL tick.
+ * @param outcome: HTTP_OUTCOME_RETRY or HTTP_OUTCOME_REJECTED.
+ */
+static void http_retry_request(uint8_t lane, uint32_t tick, uint8_t outcome) {
+    
+    HttpRequestRecord* record = http_lane_head(lane);
+    request_in_flight = false;
+    record->attempts++;
+    
+    if (outcome == HTTP_OUTCOME_REJECTED) {
+        server_error("HTTP request %lu rejected", record->seq);
+        http_pop_request(lane, HTTP_OUTCOME_REJECTED);
+        return;
+    }
+    
+    if (record->attempts >= HTTP_MAX_ATTEMPTS) {
+        server_error("HTTP request %lu abandoned after %lu attempts", record->seq, record->attempts);
+        http_pop_request(lane, HTTP_OUTCOME_FAILED);
+        return;
+    }
+    
+    uint32_t delay = http_backoff_ms(record->attempts);
+    record->retry_tick = tick + delay;
+    server_log("HTTP request %lu will be retried in %lu ms", record->seq, delay);
+}
+
+
+/**
+ * @brief Calculate the wait before the next attempt at a request.
+ *
+ * The delay doubles with each attempt up to HTTP_RETRY_MAX_MS, and is
+ * then randomized down by up to half, so devices that failed together
+ * don't all retry together.
+ *
+ * @param attempts: The number of attempts made so far.
+ *
+ * @returns The delay in milliseconds.
+ */
+static uint32_t http_backoff_ms(uint32_t attempts) {
+    
+    uint32_t delay = HTTP_RETRY_BASE_MS;
+    while (--attempts > 0 && delay < HTTP_RETRY_MAX_MS) delay <<= 1;
+    if (delay > HTTP_RETRY_MAX_MS) delay = HTTP_RETRY_MAX_MS;
+    
+    // Xorshift32, seeded from the clock on first use
+    if (jitter_state == 0) jitter_state = HAL_GetTick() | 1;
+    jitter_state ^= jitter_state << 13;
+    jitter_state ^= jitter_state >> 17;
+    jitter_state ^= jitter_state << 5;
+    
+    return delay - (jitter_state % (delay / 2 + 1));
+}
+
+
+/**
+ * @brief Classify a Microvisor status returned while issuing a request.
+ *
+ * @param status: The status.
+ *
+ * @returns HTTP_OUTCOME_RETRY if another attempt may succeed,
+ *          otherwise HTTP_OUTCOME_REJECTED.
+ */
+static uint8_t http_classify_status(enum MvStatus status) {
+    
+    switch (status) {
+        case MV_STATUS_CHANNELCLOSED:
+        case MV_STATUS_INVALIDHANDLE:
+        case MV_STATUS_RATELIMITED:
+        case MV_STATUS_UNAVAILABLE:
+            return HTTP_OUTCOME_RETRY;
+        default:
+            return HTTP_OUTCOME_REJECTED;
+    }
+}
+
+
+/**
+ * @brief Send the request at the head of a lane's queue, opening
+ *        the HTTP channel first if necessary.
+ *
+ * @param lane: The lane.
+ * @param tick: The current HAL tick.
+ */
+static void http_issue_next_request(uint8_t lane, uint32_t tick) {
+    
+    // Open a channel if we don't have one. If this fails,
+    // it counts as a failed attempt at the request
+    if (http_handles.channel == 0 && !http_open_channel()) {
+        http_retry_request(lane, tick, HTTP_OUTCOME_RETRY);
+        return;
+    }
+    
+    HttpRequestRecord* record = http_lane_head(lane);
+    
     struct MvHttpRequest request_config = {
         .method = {
-            .data = (uint8_t *)verb,
-            .length = strlen(verb)
+            .data = (const uint8_t *)verb,
+            .length = sizeof(verb) - 1
         },
         .url = {
-            .data = (uint8_t *)uri,
-            .length = strlen(uri)
+            .data = (const uint8_t *)uri,
+            .length = sizeof(uri) - 1
         },
-        .num_headers = 0,
+        .num_headers = sizeof(headers) / sizeof(headers[0]),
         .headers = headers,
         .body = {
-            .data = (uint8_t *)body,
-            .length = strlen(body)
+            .data = (const uint8_t *)record->body,
+            .length = record->body_length
         },
-        .timeout_ms = 10000
+        .timeout_ms = HTTP_REQUEST_TIMEOUT_MS
     };
 
     // Issue the request -- and check its status
+    uint32_t start_cycles = cycles_now();
     enum MvStatus status = mvSendHttpRequest(http_handles.channel, &request_config);
     if (status == MV_STATUS_OKAY) {
-        server_log("Request sent to Twilio");
-    } else if (status == MV_STATUS_CHANNELCLOSED) {
-        server_error("HTTP channel %lu already closed", (uint32_t)http_handles.channel);
-    } else {
-        server_error("Could not issue request. Status: %i", status);
+        latency_record(LATENCY_STAGE_SEND, cycles_to_us(cycles_now() - start_cycles));
+        server_log("HTTP request %lu sent to Twilio", record->seq);
+        request_in_flight = true;
+        in_flight_lane = lane;
+        request_sent_tick = HAL_GetTick();
+        last_activity_tick = tick;
+        
+        // Record how long the request waited for its first transmission
+        HttpLaneStats* stats = &http_lanes[lane].stats;
+        stats->sent++;
+        if (!record->was_sent) {
+            record->was_sent = true;
+            uint32_t wait = tick - record->queued_tick;
+            http_lanes[lane].waits++;
+            http_lanes[lane].total_wait_ms += wait;
+            if (wait > stats->max_wait_ms) stats->max_wait_ms = wait;
+            if (lane == HTTP_LANE_ALERT && wait > HTTP_ALERT_TARGET_MS) stats->over_target++;
+        }
+        
+        return;
     }
     
-    return status;
+    server_error("Could not issue request %lu. Status: %i", record->seq, status);
+    
+    // Get a fresh channel for the next attempt
+    if (status == MV_STATUS_CHANNELCLOSED || status == MV_STATUS_INVALIDHANDLE) http_close_channel();
+    http_retry_request(lane, tick, http_classify_status(status));
 }
 
 
 /**
- * @brief Send a stock HTTP request.
+ * @brief Work out when `http_service()` next has timed work to do.
+ *
+ * The checks mirror those in `http_service()`, whose comparisons are
+ * strict, hence the extra millisecond on some deadlines.
  *
- * @returns The request's MvStatus.
+ * @param tick: The current HAL tick.
+ *
+ * @returns The time in ms until the earliest deadline.
  */
-enum MvStatus http_send_request(double temp) {
+static uint32_t http_time_to_next_action(uint32_t tick) {
+    
+    uint32_t wait = http_time_until(stats_tick + HTTP_STATS_PERIOD_MS + 1, tick);
+    uint32_t next = 0;
     
-    // Check for a valid channel handle
-    if (http_handles.channel == 0) {
-        // There's no open channel, so open open one now and
-        // try to send again
-        http_open_channel();
-        return http_send_request(temp);
+    if (request_in_flight) {
+        // The channel watchdog, and preemption by an alert
+        next = http_time_until(request_sent_tick + CHANNEL_KILL_PERIOD_MS + 1, tick);
+        if (next < wait) wait = next;
+        if (in_flight_lane != HTTP_LANE_ALERT && http_lanes[HTTP_LANE_ALERT].count > 0) {
+            next = http_time_until(http_lane_head(HTTP_LANE_ALERT)->retry_tick + HTTP_ALERT_TARGET_MS, tick);
+            if (next < wait) wait = next;
+        }
+        
+        return wait;
+    }
+    
+    // Each lane's next attempt and deadline. Requests held
+    // back because we're offline wait for the caller's poll
+    bool is_idle = true;
+    bool can_send = http_handles.channel != 0 || net_is_connected();
+    for (uint8_t lane = 0 ; lane < HTTP_LANE_COUNT ; ++lane) {
+        if (http_lanes[lane].count == 0) continue;
+        is_idle = false;
+        
+        HttpRequestRecord* record = http_lane_head(lane);
+        next = http_time_until(record->queued_tick + HTTP_REQUEST_DEADLINE_MS + 1, tick);
+        if (next < wait) wait = next;
+        next = http_time_until(record->retry_tick, tick);
+        if (can_send && next < wait) wait = next;
     }
+    
+    // Closing the idle channel
+    if (is_idle && http_handles.channel != 0) {
+        next = http_time_until(last_activity_tick + HTTP_CHANNEL_IDLE_MS + 1, tick);
+        if (next < wait) wait = next;
+    }
+    
+    return wait;
+}
 
-    server_log("Sending HTTP request");
 
-    static char body[48] = {0};
-    snprintf(body, 47, "{\"temp\":%.02f}", temp);
+/**
+ * @brief Get the time remaining until a deadline.
+ *
+ * @param deadline: The deadline's HAL tick.
+ * @param tick:     The current HAL tick.
+ *
+ * @returns The time in ms, or 0 if the deadline has passed.
+ */
+static uint32_t http_time_until(uint32_t deadline, uint32_t tick) {
+    
+    int32_t remaining = (int32_t)(deadline - tick);
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
 
-    // Set up the request
-    static const char verb[] = "POST";
-    static const char uri[] = API_URL;
 
-    // Add a header
-    static const char header_text[] = "Content-Type: application/json";
-    struct MvHttpHeader header = {
-        .data = (uint8_t *)header_text,
-        .length = strlen(header_text)
-    };
+/**
+ * @brief Log each request lane's queue depth and wait times.
+ */
+static void http_log_lane_stats(void) {
+    
+    for (uint8_t lane = 0 ; lane < HTTP_LANE_COUNT ; ++lane) {
+        HttpLaneStats stats;
+        http_get_lane_stats(lane, &stats);
+        server_log("HTTP %s lane: depth %lu (max %lu), wait %lu ms mean, %lu ms max, %lu sent, %lu preempted, %lu over target",
+                   lane_names[lane], stats.depth, stats.max_depth, stats.mean_wait_ms, stats.max_wait_ms,
+                   stats.sent, stats.preempted, stats.over_target);
+    }
+}
 
-    struct MvHttpHeader headers[] = { header };
-    struct MvHttpRequest request_config = {
-        .method = {
-            .data = (uint8_t *)verb,
-            .length = strlen(verb)
-        },
-        .url = {
-            .data = (uint8_t *)uri,
-            .length = strlen(uri)
-        },
-        .num_headers = 0,
-        .headers = headers,
-        .body = {
-            .data = (uint8_t *)body,
-            .length = strlen(body)
-        },
-        .timeout_ms = 10000
-    };
 
-    // Issue the request -- and check its status
-    enum MvStatus status = mvSendHttpRequest(http_handles.channel, &request_config);
+/**
+ * @brief Process the response to the request in flight.
+ *
+ * @returns HTTP_OUTCOME_DELIVERED if the server accepted the request,
+ *          HTTP_OUTCOME_RETRY if the failure may be transient,
+ *          otherwise HTTP_OUTCOME_REJECTED.
+ */
+static uint8_t http_process_response(void) {
+    
+    uint32_t seq = http_lane_head(in_flight_lane)->seq;
+    
+    // We have received data via the active HTTP channel so establish
+    // an `MvHttpResponseData` record to hold response metadata
+    struct MvHttpResponseData resp_data;
+    enum MvStatus status = mvReadHttpResponseData(http_handles.channel, &resp_data);
+    if (status != MV_STATUS_OKAY) {
+        server_error("Response data read failed. Status: %i", status);
+        return HTTP_OUTCOME_RETRY;
+    }
+    
+    // Check we successfully issued the request (`result` is OK). Only a
+    // failure to reach the server is worth retrying: the other results
+    // mean the request or its response can't be handled
+    if (resp_data.result != MV_HTTPRESULT_OK) {
+        server_error("Request %lu failed. Status: %i", seq, resp_data.result);
+        return resp_data.result == MV_HTTPRESULT_REQUESTFAILED ? HTTP_OUTCOME_RETRY : HTTP_OUTCOME_REJECTED;
+    }
+    
+    // Check the request was successful (status code 2xx). Time-outs,
+    // rate limiting and server errors are worth retrying; other
+    // statuses mean the server won't accept this request
+    if (resp_data.status_code < 200 || resp_data.status_code > 299) {
+        server_error("HTTP status code: %lu (request %lu)", resp_data.status_code, seq);
+        if (resp_data.status_code == 408 || resp_data.status_code == 429 || resp_data.status_code >= 500) return HTTP_OUTCOME_RETRY;
+        return HTTP_OUTCOME_REJECTED;
+    }
+    
+    server_log("HTTP response to request %lu", seq);
+    server_log("HTTP response header count: %lu", resp_data.num_headers);
+    server_log("HTTP response body length: %lu", resp_data.body_length);
+    
+    // Stream the body through a fixed-size buffer, so stack
+    // use doesn't depend on how much the server sends, and
+    // apply any settings it contains
+    uint8_t buffer[HTTP_BODY_CHUNK_SIZE_B];
+    ConfigUpdate update;
+    config_update_begin(&update);
+    status = http_read_body(resp_data.body_length, buffer, sizeof(buffer), http_handle_body_chunk, &update);
     if (status == MV_STATUS_OKAY) {
-        server_log("Request sent to Twilio");
-    } else if (status == MV_STATUS_CHANNELCLOSED) {
-        server_error("HTTP channel %lu already closed", (uint32_t)http_handles.channel);
+        config_update_end(&update);
     } else {
-        server_error("Could not issue request. Status: %i", status);
+        server_error("HTTP response body read status %i", status);
     }
     
-    return status;
+    // The server accepted the request, even if we couldn't read its reply
+    return HTTP_OUTCOME_DELIVERED;
 }
 
 
 /**
- * @brief The HTTP channel notification interrupt handler.
+ * @brief Read the current response body in chunks.
+ *
+ * Each chunk is read into the caller's buffer and passed to `handler`,
+ * which may stop the read early by returning `false`. Memory use is
+ * bounded by the buffer, however large the body is.
  *
- * This is called by Microvisor -- we need to check for key events
- * and extract HTTP response data when it is available.
+ * @param body_length: The body length reported in the response data.
+ * @param buffer:      A buffer to read each chunk into.
+ * @param buffer_size: The size of the buffer in bytes.
+ * @param handler:     The function to pass each chunk to.
+ * @param context:     A value passed through to `handler`.
+ *
+ * @returns The first non-OK read status, otherwise `MV_STATUS_OKAY`.
  */
-void TIM8_BRK_IRQHandler(void) {
+enum MvStatus http_read_body(uint32_t body_length, uint8_t* buffer, uint32_t buffer_size, HttpBodyHandler handler, void* context) {
     
-    // Check for a suitable event: readable data in the channel
-    bool got_notification = false;
-    volatile struct MvNotification notification = http_notification_center[current_notification_index];
-    if (notification.event_type == MV_EVENTTYPE_CHANNELDATAREADABLE) {
-        // Flag we need to access received data and to close the HTTP channel
-        // when we're back in the main loop. This lets us exit the ISR quickly.
-        // We should not make Microvisor System Calls in the ISR.
-        received_request = true;
-        got_notification = true;
+    uint32_t offset = 0;
+    while (offset < body_length) {
+        uint32_t length = body_length - offset;
+        if (length > buffer_size) length = buffer_size;
+        
+        enum MvStatus status = mvReadHttpResponseBody(http_handles.channel, offset, buffer, length);
+        if (status != MV_STATUS_OKAY) return status;
+        if (!handler(buffer, length, offset, context)) break;
+        offset += length;
     }
     
-    if (notification.event_type == MV_EVENTTYPE_CHANNELNOTCONNECTED) {
-        channel_was_closed = true;
-        got_notification = true;
+    return MV_STATUS_OKAY;
+}
+
+
+/**
+ * @brief Log a chunk of a response body and pass it to the settings parser.
+ *
+ * @param data:    The chunk's bytes.
+ * @param length:  The number of bytes in the chunk.
+ * @param offset:  The chunk's position in the body.
+ * @param context: A pointer to a ConfigUpdate record.
+ *
+ * @returns `true` to continue reading.
+ */
+static bool http_handle_body_chunk(const uint8_t* data, uint32_t length, uint32_t offset, void* context) {
+    
+    if (offset == 0) server_log("Message body:");
+    server_log("%.*s", (int)length, (const char *)data);
+    
+    // Keep reading to log the whole body, even if it isn't settings JSON
+    config_update_feed((ConfigUpdate*)context, data, length);
+    return true;
+}
+
+
+/**
+ * @brief Add an event to the queue. Called only by the notification ISR.
+ *
+ * @param type: The event type, eg. HTTP_EVENT_READABLE.
+ * @param tag:  The notification's tag.
+ */
+static void http_push_event(uint8_t type, uint32_t tag) {
+    
+    uint32_t tail = event_tail;
+    if (tail - event_head == HTTP_EVENT_QUEUE_SIZE_R) {
+        event_stats.queue_overruns++;
+        return;
     }
     
-    if (got_notification) {
-        // Point to the next record to be written
-        current_notification_index = (current_notification_index + 1) % HTTP_NT_BUFFER_SIZE_R;
+    volatile HttpEvent* event = &http_event_queue[tail & (HTTP_EVENT_QUEUE_SIZE_R - 1)];
+    event->type = type;
+    event->tag = tag;
+    event->tick = HAL_GetTick();
+    
+    // Publish the event only once it is complete
+    __DMB();
+    event_tail = tail + 1;
+}
 
-        // Clear the current notifications event
-        // See https://www.twilio.com/docs/iot/microvisor/microvisor-notifications#buffer-overruns
-        notification.event_type = 0;
+
+/**
+ * @brief Take the oldest event from the queue. Called only by `http_service()`.
+ *
+ * @param event: Set to the event, if there is one.
+ *
+ * @returns `true` if an event was taken, otherwise `false`.
+ */
+static bool http_pop_event(HttpEvent* event) {
+    
+    uint32_t head = event_head;
+    if (head == event_tail) return false;
+    
+    volatile HttpEvent* next = &http_event_queue[head & (HTTP_EVENT_QUEUE_SIZE_R - 1)];
+    event->type = next->type;
+    event->tag = next->tag;
+    event->tick = next->tick;
+    
+    // Release the slot only once it has been read
+    __DMB();
+    event_head = head + 1;
+    return true;
+}
+
+
+/**
+ * @brief The HTTP channel notification interrupt handler.
+ *
+ * This is called by Microvisor when it has written one or more records
+ * to the notification center. We drain every pending record, in order,
+ * into the event queue, clearing each one so it isn't read again, and
+ * then wake the consuming task. We should not make Microvisor System
+ * Calls in the ISR, so the events are handled by `http_service()`.
+ *
+ * See https://www.twilio.com/docs/iot/microvisor/microvisor-notifications#buffer-overruns
+ */
+void TIM8_BRK_IRQHandler(void) {
+    
+    uint32_t drained = 0;
+    while (drained < HTTP_NT_BUFFER_SIZE_R) {
+        // Records are cleared to 0 once read; unused ones hold the setup fill
+        volatile struct MvNotification* notification = &http_notification_center[current_notification_index];
+        uint32_t event_type = notification->event_type;
+        if (event_type == 0 || event_type == 0xFFFFFFFF) break;
+        
+        if (event_type == MV_EVENTTYPE_CHANNELDATAREADABLE) {
+            http_push_event(HTTP_EVENT_READABLE, notification->tag);
+        } else if (event_type == MV_EVENTTYPE_CHANNELNOTCONNECTED) {
+            http_push_event(HTTP_EVENT_CLOSED, notification->tag);
+        } else {
+            event_stats.ignored++;
+        }
+        
+        notification->event_type = 0;
+        current_notification_index = (current_notification_index + 1) % HTTP_NT_BUFFER_SIZE_R;
+        drained++;
     }
- }
+    
+    // A full ring means Microvisor may have had to drop records
+    event_stats.notifications += drained;
+    if (drained == HTTP_NT_BUFFER_SIZE_R) event_stats.ring_full++;
+    if (drained > 0 && consumer_task != NULL) osThreadFlagsSet(consumer_task, HTTP_EVENT_FLAG);
+}
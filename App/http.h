@@ -10,6 +10,107 @@
 #define _HTTP_H_
 
 
+/*
+ * CONSTANTS
+ */
+#define     HTTP_RX_BUFFER_SIZE_B       1536
+#define     HTTP_TX_BUFFER_SIZE_B       512
+
+// Space reserved in the send buffer for Microvisor's own
+// request framing, ie. the bytes that aren't method, URL,
+// headers or body
+#define     HTTP_TX_OVERHEAD_B          96
+#define     HTTP_MAX_BODY_LEN_B         (HTTP_TX_BUFFER_SIZE_B - HTTP_TX_OVERHEAD_B - sizeof(API_URL))
+
+#define     HTTP_ALERT_QUEUE_SIZE_R     2             // NOTE Sizes in records, not bytes
+#define     HTTP_BULK_QUEUE_SIZE_R      4
+#define     HTTP_REQUEST_TIMEOUT_MS     10000
+#define     HTTP_REQUEST_DEADLINE_MS    300000
+#define     HTTP_MAX_ATTEMPTS           6
+#define     HTTP_RETRY_BASE_MS          2000
+#define     HTTP_RETRY_MAX_MS           60000
+#define     HTTP_BODY_CHUNK_SIZE_B      128
+#define     HTTP_ALERT_TARGET_MS        2000
+#define     HTTP_STATS_PERIOD_MS        300000
+#define     HTTP_EVENT_QUEUE_SIZE_R     16            // NOTE Must be a power of two
+
+// Thread flag set on the task calling `http_service()` when events arrive
+#define     HTTP_EVENT_FLAG             0x0001
+
+// Channel events queued by the notification ISR
+#define     HTTP_EVENT_READABLE         1       // A response is ready to read
+#define     HTTP_EVENT_CLOSED           2       // The channel was disconnected
+
+// Request lanes, highest priority first
+#define     HTTP_LANE_ALERT             0       // Warnings, which must go out promptly
+#define     HTTP_LANE_BULK              1       // Routine telemetry
+#define     HTTP_LANE_COUNT             2
+
+// Request outcomes
+#define     HTTP_OUTCOME_DELIVERED      0       // The server accepted the request
+#define     HTTP_OUTCOME_RETRY          1       // A transient failure: try again
+#define     HTTP_OUTCOME_FAILED         2       // Gave up after repeated transient failures
+#define     HTTP_OUTCOME_REJECTED       3       // A permanent failure: don't send again
+
+
+/*
+ * MACROS
+ */
+// Append a string literal, its length known at compile time
+#define     http_body_append_literal(body, text)    http_body_append((body), (text), sizeof(text) - 1)
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    seq;
+    uint32_t    queued_tick;
+    uint32_t    retry_tick;
+    uint32_t    attempts;
+    bool        was_sent;
+    uint32_t    body_length;
+    char        body[HTTP_MAX_BODY_LEN_B];
+} HttpRequestRecord;    // Record for a queued outbound request
+
+typedef struct {
+    HttpRequestRecord*  record;
+    uint8_t             lane;
+    uint32_t            length;
+    bool                overflow;
+} HttpBodyBuilder;      // Record for a request body under construction
+
+typedef struct {
+    uint32_t    queued;
+    uint32_t    sent;
+    uint32_t    delivered;
+    uint32_t    failed;
+    uint32_t    rejected;
+    uint32_t    preempted;
+    uint32_t    over_target;
+    uint32_t    depth;
+    uint32_t    max_depth;
+    uint32_t    mean_wait_ms;
+    uint32_t    max_wait_ms;
+} HttpLaneStats;        // Record for a request lane's counters
+
+typedef struct {
+    uint32_t    tick;
+    uint32_t    tag;
+    uint8_t     type;
+} HttpEvent;            // Record for a queued channel event
+
+typedef struct {
+    uint32_t    notifications;
+    uint32_t    ignored;
+    uint32_t    ring_full;
+    uint32_t    queue_overruns;
+} HttpEventStats;       // Record for notification and event queue counters
+
+// Receives successive chunks of a response body. Return `false` to stop reading
+typedef bool (*HttpBodyHandler)(const uint8_t* data, uint32_t length, uint32_t offset, void* context);
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,8 +122,23 @@ extern "C" {
 void            http_notification_center_setup(void);
 bool            http_open_channel(void);
 void            http_close_channel(void);
-enum MvStatus   http_send_request(double temp);
-enum MvStatus   http_send_warning(void);
+uint32_t        http_service(void);
+bool            http_send_warning(void);
+uint32_t        http_send_samples(const TelemetrySample* samples, uint32_t count, uint32_t* seq);
+bool            http_send_features(const MotionFeatures* features);
+bool            http_queue_full(uint8_t lane);
+void            http_get_lane_stats(uint8_t lane, HttpLaneStats* data);
+void            http_get_event_stats(HttpEventStats* data);
+enum MvStatus   http_read_body(uint32_t body_length, uint8_t* buffer, uint32_t buffer_size, HttpBodyHandler handler, void* context);
+
+bool            http_body_start(HttpBodyBuilder* body, uint8_t lane);
+void            http_body_append(HttpBodyBuilder* body, const void* data, uint32_t length);
+void            http_body_append_uint(HttpBodyBuilder* body, uint32_t value);
+void            http_body_append_int(HttpBodyBuilder* body, int32_t value);
+void            http_body_append_json_string(HttpBodyBuilder* body, const char* value);
+void            http_body_append_base64(HttpBodyBuilder* body, const uint8_t* data, uint32_t length);
+uint32_t        http_body_space(const HttpBodyBuilder* body);
+uint32_t        http_body_commit(HttpBodyBuilder* body);
 
 
 #ifdef __cplusplus
@@ -13,6 +13,12 @@
  * STATIC PROTOTYPES
  */
 static bool I2C_check(uint8_t addr);
+static void I2C_start_next(void);
+static void I2C_complete(HAL_StatusTypeDef status);
+static void I2C_cancel(I2CTransaction* transaction);
+static HAL_StatusTypeDef I2C_run(I2CTransaction* transaction, uint32_t timeout_ms);
+static HAL_StatusTypeDef I2C_poll(I2CTransaction* transaction, uint32_t timeout_ms);
+static void I2C_record_acquisition(uint8_t addr, bool was_acquired, bool was_contended, uint32_t wait_ms);
 
 
 /*
@@ -21,6 +27,32 @@ static bool I2C_check(uint8_t addr);
 extern      I2C_HandleTypeDef   i2c;
 extern      bool                use_i2c;
 
+// Transactions waiting for the bus, oldest first, and the one on it.
+// These are shared with the I2C interrupt, so tasks only change them
+// with interrupts disabled
+static I2CTransaction*          queue_head = NULL;
+static I2CTransaction*          queue_tail = NULL;
+static I2CTransaction* volatile current = NULL;
+static volatile bool            is_resetting = false;
+
+// The bus lock, which tasks hold for a transfer or a batch of them.
+// It's recursive, so transfers can be made inside a batch, and it
+// has priority inheritance, so a low-priority holder can't keep
+// a high-priority waiter off the bus for longer than it must
+static osMutexId_t bus_lock = NULL;
+static const osMutexAttr_t bus_lock_attributes = {
+    .name = "I2CBus",
+    .attr_bits = osMutexRecursive | osMutexPrioInherit
+};
+
+// Arbitration counters for each device, in order of first use
+static struct {
+    uint64_t        total_wait_ms;
+    I2CClientStats  stats;
+} clients[I2C_MAX_CLIENTS];
+
+static uint8_t client_count = 0;
+
 
 /**
  * @brief Initialize STM32U585 I2C1.
@@ -101,6 +133,466 @@ void I2C_scan(void) {
 }
 
 
+/**
+ * @brief Create the bus lock.
+ *
+ * Call after `osKernelInitialize()`. Until then, and until the
+ * scheduler starts, transfers are made without locking, as there
+ * are no other tasks to contend with.
+ */
+void I2C_init_arbiter(void) {
+    
+    bus_lock = osMutexNew(&bus_lock_attributes);
+    if (bus_lock == NULL) server_error("Could not create I2C bus lock");
+}
+
+
+/**
+ * @brief Take the bus for a series of transfers.
+ *
+ * No other task can use the bus until the matching `I2C_end_batch()`,
+ * so a read-modify-write of a device register can't be interleaved
+ * with another task's transfers. Batches may nest.
+ *
+ * NOTE Transactions queued directly with `I2C_submit()` don't take the
+ *      bus lock, so they can be interleaved with a batch.
+ *
+ * @param addr:       The 7-bit address of the device, for the counters.
+ * @param timeout_ms: How long to wait for the bus.
+ *
+ * @returns `true` if the bus is ours, otherwise `false`.
+ */
+bool I2C_begin_batch(uint8_t addr, uint32_t timeout_ms) {
+    
+    if (bus_lock == NULL || osKernelGetState() != osKernelRunning) return true;
+    
+    // A nested batch, or a transfer within a batch
+    if (osMutexGetOwner(bus_lock) == osThreadGetId()) return osMutexAcquire(bus_lock, 0) == osOK;
+    
+    if (osMutexAcquire(bus_lock, 0) == osOK) {
+        I2C_record_acquisition(addr, true, false, 0);
+        return true;
+    }
+    
+    uint32_t start = HAL_GetTick();
+    bool was_acquired = osMutexAcquire(bus_lock, timeout_ms) == osOK;
+    I2C_record_acquisition(addr, was_acquired, true, HAL_GetTick() - start);
+    return was_acquired;
+}
+
+
+/**
+ * @brief Release the bus taken by `I2C_begin_batch()`.
+ */
+void I2C_end_batch(void) {
+    
+    if (bus_lock == NULL || osKernelGetState() != osKernelRunning) return;
+    if (osMutexGetOwner(bus_lock) == osThreadGetId()) osMutexRelease(bus_lock);
+}
+
+
+/**
+ * @brief Get a device's arbitration counters.
+ *
+ * @param index: The device's index, from 0 in order of first use.
+ * @param data:  Pointer to an I2CClientStats structure.
+ *               (see i2c.h)
+ *
+ * @returns `true` if there is a device at that index, otherwise `false`.
+ */
+bool I2C_get_client_stats(uint8_t index, I2CClientStats* data) {
+    
+    osKernelLock();
+    bool is_client = index < client_count;
+    if (is_client) {
+        *data = clients[index].stats;
+        data->mean_wait_ms = data->contended > 0 ? (uint32_t)(clients[index].total_wait_ms / data->contended) : 0;
+    }
+    
+    osKernelUnlock();
+    return is_client;
+}
+
+
+/**
+ * @brief Log every device's arbitration counters.
+ */
+void I2C_log_stats(void) {
+    
+    I2CClientStats stats;
+    for (uint8_t i = 0 ; I2C_get_client_stats(i, &stats) ; ++i) {
+        server_log("I2C 0x%02x: %lu acquisitions, %lu contended, %lu timed out, wait mean %lu ms max %lu ms",
+                   stats.addr, stats.acquisitions, stats.contended, stats.timeouts,
+                   stats.mean_wait_ms, stats.max_wait_ms);
+    }
+}
+
+
+/**
+ * @brief Count an attempt to take the bus.
+ *
+ * Wait times are of contended attempts only.
+ *
+ * @param addr:          The device's 7-bit address.
+ * @param was_acquired:  Whether the bus was taken.
+ * @param was_contended: Whether another task held the bus.
+ * @param wait_ms:       How long we waited for the bus.
+ */
+static void I2C_record_acquisition(uint8_t addr, bool was_acquired, bool was_contended, uint32_t wait_ms) {
+    
+    osKernelLock();
+    uint8_t index = 0;
+    while (index < client_count && clients[index].stats.addr != addr) index++;
+    if (index == client_count && client_count < I2C_MAX_CLIENTS) {
+        clients[index].stats.addr = addr;
+        client_count++;
+    }
+    
+    if (index < client_count) {
+        I2CClientStats* stats = &clients[index].stats;
+        if (was_acquired) {
+            stats->acquisitions++;
+        } else {
+            stats->timeouts++;
+        }
+        
+        if (was_contended) {
+            stats->contended++;
+            clients[index].total_wait_ms += wait_ms;
+            if (wait_ms > stats->max_wait_ms) stats->max_wait_ms = wait_ms;
+        }
+    }
+    
+    osKernelUnlock();
+}
+
+
+/**
+ * @brief Queue a transaction.
+ *
+ * The transaction writes `tx`, if there is anything to write, then
+ * reads into `rx`, if there is anything to read. If `is_register` is
+ * set, it instead writes `tx` to, or reads `rx` from, the registers
+ * from `reg` on, with a repeated START after the register address
+ * on a read. It runs on the
+ * I2C interrupt once the transactions ahead of it have finished.
+ * When it completes, `callback` is called, if set, and then the
+ * `notify` task, if set, is sent I2C_DONE_FLAG.
+ *
+ * The transaction and its buffers must remain valid until `is_done`
+ * is set.
+ *
+ * @param transaction: The transaction.
+ *
+ * @returns `true` if the transaction was queued, otherwise `false`.
+ */
+bool I2C_submit(I2CTransaction* transaction) {
+    
+    if (transaction->tx_length == 0 && transaction->rx_length == 0) return false;
+    if (transaction->is_register && transaction->tx_length > 0 && transaction->rx_length > 0) return false;
+    
+    transaction->status = HAL_BUSY;
+    transaction->is_done = false;
+    transaction->next = NULL;
+    
+    __disable_irq();
+    if (queue_tail != NULL) {
+        queue_tail->next = transaction;
+    } else {
+        queue_head = transaction;
+    }
+    
+    queue_tail = transaction;
+    I2C_start_next();
+    __enable_irq();
+    return true;
+}
+
+
+/**
+ * @brief Write and/or read, blocking the calling task until done.
+ *
+ * The write and the read are separate bus transactions, each with its
+ * own STOP. To read or write device registers, use `I2C_read_regs()`
+ * and `I2C_write_regs()` instead.
+ *
+ * NOTE Don't call this from an interrupt.
+ *
+ * @param addr:       The device's 7-bit address.
+ * @param tx:         The bytes to write, or NULL.
+ * @param tx_length:  The number of bytes to write.
+ * @param rx:         The buffer to read into, or NULL.
+ * @param rx_length:  The number of bytes to read.
+ * @param timeout_ms: How long to wait, including for the bus.
+ *
+ * @returns The HAL status of the transfer.
+ */
+HAL_StatusTypeDef I2C_transfer(uint8_t addr, const uint8_t* tx, uint16_t tx_length, uint8_t* rx, uint16_t rx_length, uint32_t timeout_ms) {
+    
+    I2CTransaction transaction = {
+        .addr = addr,
+        .tx = tx,
+        .tx_length = tx_length,
+        .rx = rx,
+        .rx_length = rx_length
+    };
+    
+    return I2C_run(&transaction, timeout_ms);
+}
+
+
+/**
+ * @brief Read one or more consecutive registers, blocking the calling task until done.
+ *
+ * The register address is written and the data read in a single bus
+ * transaction, joined by a repeated START, so no other bus master can
+ * come between them, and it costs one HAL call rather than two.
+ *
+ * NOTE Some devices only step through registers on a multi-byte read
+ *      if the register address says so -- see the device's driver.
+ *
+ * @param addr:       The device's 7-bit address.
+ * @param reg:        The first register's address.
+ * @param data:       The buffer to read into.
+ * @param length:     The number of bytes to read.
+ * @param timeout_ms: How long to wait, including for the bus.
+ *
+ * @returns The HAL status of the read.
+ */
+HAL_StatusTypeDef I2C_read_regs(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t length, uint32_t timeout_ms) {
+    
+    I2CTransaction transaction = {
+        .addr = addr,
+        .is_register = true,
+        .reg = reg,
+        .rx = data,
+        .rx_length = length
+    };
+    
+    return I2C_run(&transaction, timeout_ms);
+}
+
+
+/**
+ * @brief Write one or more consecutive registers, blocking the calling task until done.
+ *
+ * The register address and the data go out in a single bus transaction,
+ * so a burst of registers costs the same bus overhead as a single one.
+ *
+ * @param addr:       The device's 7-bit address.
+ * @param reg:        The first register's address.
+ * @param data:       The bytes to write.
+ * @param length:     The number of bytes to write.
+ * @param timeout_ms: How long to wait, including for the bus.
+ *
+ * @returns The HAL status of the write.
+ */
+HAL_StatusTypeDef I2C_write_regs(uint8_t addr, uint8_t reg, const uint8_t* data, uint16_t length, uint32_t timeout_ms) {
+    
+    I2CTransaction transaction = {
+        .addr = addr,
+        .is_register = true,
+        .reg = reg,
+        .tx = data,
+        .tx_length = length
+    };
+    
+    return I2C_run(&transaction, timeout_ms);
+}
+
+
+/**
+ * @brief Run a transaction, blocking the calling task until done.
+ *
+ * The task sleeps while the bus is busy, so other tasks can run. The
+ * bus lock is held for the transaction, so it waits for any other task's
+ * batch to end. Before the scheduler starts there is no task to put to
+ * sleep, so the transaction is made by polling instead.
+ *
+ * While the calling task has the scheduler locked it can't sleep either,
+ * but the I2C interrupt may still be running a queued transaction, or
+ * another task may be part-way through a batch. Then the bus is not
+ * ours and the call fails with HAL_BUSY; otherwise it polls.
+ *
+ * @param transaction: The transaction, with the caller's fields set.
+ * @param timeout_ms:  How long to wait, including for the bus.
+ *
+ * @returns The HAL status of the transaction.
+ */
+static HAL_StatusTypeDef I2C_run(I2CTransaction* transaction, uint32_t timeout_ms) {
+    
+    osKernelState_t state = osKernelGetState();
+    if (state == osKernelInactive || state == osKernelReady) return I2C_poll(transaction, timeout_ms);
+    
+    if (state != osKernelRunning) {
+        if (current != NULL || queue_head != NULL || is_resetting) return HAL_BUSY;
+        if (bus_lock != NULL) {
+            osThreadId_t owner = osMutexGetOwner(bus_lock);
+            if (owner != NULL && owner != osThreadGetId()) return HAL_BUSY;
+        }
+        
+        return I2C_poll(transaction, timeout_ms);
+    }
+    
+    uint32_t start = HAL_GetTick();
+    if (!I2C_begin_batch(transaction->addr, timeout_ms)) return HAL_BUSY;
+    
+    transaction->notify = osThreadGetId();
+    osThreadFlagsClear(I2C_DONE_FLAG);
+    if (!I2C_submit(transaction)) {
+        I2C_end_batch();
+        return HAL_ERROR;
+    }
+    
+    while (!transaction->is_done) {
+        uint32_t elapsed = HAL_GetTick() - start;
+        if (elapsed >= timeout_ms) {
+            I2C_cancel(transaction);
+            break;
+        }
+        
+        osThreadFlagsWait(I2C_DONE_FLAG, osFlagsWaitAny, timeout_ms - elapsed);
+    }
+    
+    I2C_end_batch();
+    return transaction->status;
+}
+
+
+/**
+ * @brief Run a transaction with the blocking HAL calls.
+ *
+ * @param transaction: The transaction.
+ * @param timeout_ms:  The HAL time-out for each call.
+ *
+ * @returns The HAL status of the transaction.
+ */
+static HAL_StatusTypeDef I2C_poll(I2CTransaction* transaction, uint32_t timeout_ms) {
+    
+    uint16_t addr = transaction->addr << 1;
+    if (transaction->is_register) {
+        if (transaction->tx_length > 0) {
+            return HAL_I2C_Mem_Write(&i2c, addr, transaction->reg, I2C_MEMADD_SIZE_8BIT, (uint8_t*)transaction->tx, transaction->tx_length, timeout_ms);
+        }
+        
+        return HAL_I2C_Mem_Read(&i2c, addr, transaction->reg, I2C_MEMADD_SIZE_8BIT, transaction->rx, transaction->rx_length, timeout_ms);
+    }
+    
+    HAL_StatusTypeDef status = HAL_OK;
+    if (transaction->tx_length > 0) status = HAL_I2C_Master_Transmit(&i2c, addr, (uint8_t*)transaction->tx, transaction->tx_length, timeout_ms);
+    if (status == HAL_OK && transaction->rx_length > 0) status = HAL_I2C_Master_Receive(&i2c, addr, transaction->rx, transaction->rx_length, timeout_ms);
+    return status;
+}
+
+
+/**
+ * @brief Start the transaction at the head of the queue, if the bus is free.
+ *
+ * NOTE Call with interrupts disabled, or from the I2C interrupt.
+ */
+static void I2C_start_next(void) {
+    
+    while (current == NULL && queue_head != NULL && !is_resetting) {
+        I2CTransaction* transaction = queue_head;
+        queue_head = transaction->next;
+        if (queue_head == NULL) queue_tail = NULL;
+        current = transaction;
+        
+        HAL_StatusTypeDef status;
+        uint16_t addr = transaction->addr << 1;
+        if (transaction->is_register && transaction->tx_length > 0) {
+            status = HAL_I2C_Mem_Write_IT(&i2c, addr, transaction->reg, I2C_MEMADD_SIZE_8BIT, (uint8_t*)transaction->tx, transaction->tx_length);
+        } else if (transaction->is_register) {
+            status = HAL_I2C_Mem_Read_IT(&i2c, addr, transaction->reg, I2C_MEMADD_SIZE_8BIT, transaction->rx, transaction->rx_length);
+        } else if (transaction->tx_length > 0) {
+            status = HAL_I2C_Master_Transmit_IT(&i2c, addr, (uint8_t*)transaction->tx, transaction->tx_length);
+        } else {
+            status = HAL_I2C_Master_Receive_IT(&i2c, addr, transaction->rx, transaction->rx_length);
+        }
+        
+        // If it couldn't start, fail it and try the next one
+        if (status != HAL_OK) I2C_complete(status);
+    }
+}
+
+
+/**
+ * @brief Retire the transaction on the bus.
+ *
+ * NOTE Call with interrupts disabled, or from the I2C interrupt.
+ *
+ * @param status: The transaction's outcome.
+ */
+static void I2C_complete(HAL_StatusTypeDef status) {
+    
+    I2CTransaction* transaction = current;
+    if (transaction == NULL) return;
+    current = NULL;
+    
+    transaction->status = status;
+    transaction->is_done = true;
+    if (transaction->callback != NULL) transaction->callback(transaction, transaction->context);
+    if (transaction->notify != NULL) osThreadFlagsSet(transaction->notify, I2C_DONE_FLAG);
+}
+
+
+/**
+ * @brief Give up on a transaction that has timed out.
+ *
+ * If it's still queued, it's removed. If it's on the bus, the peripheral
+ * is reset, so the transfer can't touch the caller's buffers after we
+ * return, and the queue is restarted.
+ *
+ * @param transaction: The transaction.
+ */
+static void I2C_cancel(I2CTransaction* transaction) {
+    
+    bool was_current = false;
+    __disable_irq();
+    if (transaction->is_done) {
+        // It completed just as it timed out
+        __enable_irq();
+        return;
+    }
+    
+    if (current == transaction) {
+        current = NULL;
+        is_resetting = true;
+        was_current = true;
+    } else {
+        I2CTransaction* previous = NULL;
+        for (I2CTransaction* next = queue_head ; next != NULL ; next = next->next) {
+            if (next == transaction) {
+                if (previous != NULL) {
+                    previous->next = transaction->next;
+                } else {
+                    queue_head = transaction->next;
+                }
+                
+                if (queue_tail == transaction) queue_tail = previous;
+                break;
+            }
+            
+            previous = next;
+        }
+    }
+    
+    transaction->status = HAL_TIMEOUT;
+    transaction->is_done = true;
+    __enable_irq();
+    
+    if (was_current) {
+        HAL_I2C_DeInit(&i2c);
+        HAL_I2C_Init(&i2c);
+        
+        __disable_irq();
+        is_resetting = false;
+        I2C_start_next();
+        __enable_irq();
+    }
+}
+
+
 /**
  * @brief HAL-called function to configure I2C.
  *
@@ -139,4 +631,97 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef *i2c) {
 
     // Enable the I2C1 clock
     __HAL_RCC_I2C1_CLK_ENABLE();
+    
+    // Enable the I2C1 interrupts, at a priority that
+    // allows their handlers to notify tasks
+    HAL_NVIC_SetPriority(I2C1_EV_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C1_ER_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
+}
+
+
+/**
+ * @brief HAL-called function on completion of a write.
+ *
+ * If the transaction reads too, start the read, otherwise it's done.
+ *
+ * @param i2c: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *i2c) {
+    
+    I2CTransaction* transaction = current;
+    if (transaction == NULL) return;
+    
+    if (transaction->rx_length > 0) {
+        HAL_StatusTypeDef status = HAL_I2C_Master_Receive_IT(i2c, transaction->addr << 1, transaction->rx, transaction->rx_length);
+        if (status == HAL_OK) return;
+        I2C_complete(status);
+    } else {
+        I2C_complete(HAL_OK);
+    }
+    
+    I2C_start_next();
+}
+
+
+/**
+ * @brief HAL-called function on completion of a read.
+ *
+ * @param i2c: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *i2c) {
+    
+    I2C_complete(HAL_OK);
+    I2C_start_next();
+}
+
+
+/**
+ * @brief HAL-called function on completion of a register write.
+ *
+ * @param i2c: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *i2c) {
+    
+    I2C_complete(HAL_OK);
+    I2C_start_next();
+}
+
+
+/**
+ * @brief HAL-called function on completion of a register read.
+ *
+ * @param i2c: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *i2c) {
+    
+    I2C_complete(HAL_OK);
+    I2C_start_next();
+}
+
+
+/**
+ * @brief HAL-called function on a bus error or NACK.
+ *
+ * @param i2c: A HAL I2C_HandleTypeDef pointer to the I2C instance.
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *i2c) {
+    
+    I2C_complete(HAL_ERROR);
+    I2C_start_next();
+}
+
+
+/**
+ * @brief Interrupt handlers as specified in HAL doc.
+ */
+void I2C1_EV_IRQHandler(void) {
+    
+    HAL_I2C_EV_IRQHandler(&i2c);
+}
+
+void I2C1_ER_IRQHandler(void) {
+    
+    HAL_I2C_ER_IRQHandler(&i2c);
 }
@@ -15,6 +15,49 @@
  */
 #define     I2C_GPIO_BANK           GPIOB
 
+// Thread flag set on a task waiting in `I2C_transfer()`.
+// Tasks must not use it for their own notifications
+#define     I2C_DONE_FLAG           0x0100
+
+#define     I2C_MAX_CLIENTS         4
+#define     I2C_BATCH_TIMEOUT_MS    1000
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct I2CTransaction I2CTransaction;
+
+// Called when a transaction completes. NOTE This runs in the I2C interrupt
+typedef void (*I2CCallback)(I2CTransaction* transaction, void* context);
+
+struct I2CTransaction {
+    // Set by the caller
+    uint8_t                     addr;
+    bool                        is_register;
+    uint8_t                     reg;
+    const uint8_t*              tx;
+    uint16_t                    tx_length;
+    uint8_t*                    rx;
+    uint16_t                    rx_length;
+    I2CCallback                 callback;
+    void*                       context;
+    osThreadId_t                notify;
+    // Set by the engine
+    volatile HAL_StatusTypeDef  status;
+    volatile bool               is_done;
+    I2CTransaction*             next;
+};                      // Record for a queued write and/or read, or register access
+
+typedef struct {
+    uint8_t     addr;
+    uint32_t    acquisitions;
+    uint32_t    contended;
+    uint32_t    timeouts;
+    uint32_t    mean_wait_ms;
+    uint32_t    max_wait_ms;
+} I2CClientStats;       // Record for a device's bus arbitration counters
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,8 +67,17 @@ extern "C" {
 /*
  * PROTOTYPES
  */
-void I2C_init(void);
-void I2C_scan(void);
+void                I2C_init(void);
+void                I2C_scan(void);
+void                I2C_init_arbiter(void);
+bool                I2C_begin_batch(uint8_t addr, uint32_t timeout_ms);
+void                I2C_end_batch(void);
+bool                I2C_get_client_stats(uint8_t index, I2CClientStats* data);
+void                I2C_log_stats(void);
+bool                I2C_submit(I2CTransaction* transaction);
+HAL_StatusTypeDef   I2C_transfer(uint8_t addr, const uint8_t* tx, uint16_t tx_length, uint8_t* rx, uint16_t rx_length, uint32_t timeout_ms);
+HAL_StatusTypeDef   I2C_read_regs(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t length, uint32_t timeout_ms);
+HAL_StatusTypeDef   I2C_write_regs(uint8_t addr, uint8_t reg, const uint8_t* data, uint16_t length, uint32_t timeout_ms);
 
 
 #ifdef __cplusplus
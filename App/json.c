@@ -0,0 +1,345 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define     STATE_VALUE                 0       // Expecting a value
+#define     STATE_KEY                   1       // Expecting a member name or '}'
+#define     STATE_COLON                 2       // Expecting ':' after a member name
+#define     STATE_STRING                3       // Inside a string
+#define     STATE_ESCAPE                4       // After a '\' in a string
+#define     STATE_UNICODE               5       // Inside a '\uXXXX' escape
+#define     STATE_LITERAL               6       // Inside a number, `true`, `false` or `null`
+#define     STATE_AFTER_VALUE           7       // Expecting ',' or a closing bracket
+#define     STATE_DONE                  8       // Top-level value complete
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static bool json_process(JsonParser* parser, char c);
+static bool json_end_literal(JsonParser* parser);
+static bool json_end_value(JsonParser* parser);
+static void json_add_to_token(JsonParser* parser, char c);
+static bool json_is_number(const char* text);
+static bool json_is_space(char c);
+
+
+/**
+ * @brief Prepare a parser for a new document.
+ *
+ * The parser holds all of its state, so it can be fed a document
+ * in chunks of any size, and needs no memory beyond the struct.
+ * Tokens longer than JSON_MAX_TOKEN_LEN are truncated, and flagged
+ * as such in the parser's `truncated` field while they are reported.
+ *
+ * @param parser:  A pointer to the parser.
+ * @param handler: The function to pass each scalar value to.
+ * @param context: A value passed through to `handler`.
+ */
+void json_init(JsonParser* parser, JsonValueHandler handler, void* context) {
+    
+    memset(parser, 0x00, sizeof(JsonParser));
+    parser->handler = handler;
+    parser->context = context;
+    parser->state = STATE_VALUE;
+}
+
+
+/**
+ * @brief Pass the next chunk of a document to a parser.
+ *
+ * @param parser: A pointer to the parser.
+ * @param data:   The chunk's bytes.
+ * @param length: The number of bytes in the chunk.
+ *
+ * @returns `false` if the document is malformed, otherwise `true`.
+ */
+bool json_feed(JsonParser* parser, const uint8_t* data, uint32_t length) {
+    
+    for (uint32_t i = 0 ; i < length && !parser->error ; ++i) {
+        if (!json_process(parser, (char)data[i])) parser->error = true;
+    }
+    
+    return !parser->error;
+}
+
+
+/**
+ * @brief Signal the end of a document.
+ *
+ * @param parser: A pointer to the parser.
+ *
+ * @returns `true` if the document was complete and well formed, otherwise `false`.
+ */
+bool json_finish(JsonParser* parser) {
+    
+    // A top-level number has no terminator, so end it here
+    if (!parser->error && parser->state == STATE_LITERAL) {
+        if (!json_end_literal(parser)) parser->error = true;
+    }
+    
+    return !parser->error && parser->state == STATE_DONE;
+}
+
+
+/**
+ * @brief Advance the parser by one character.
+ *
+ * @param parser: A pointer to the parser.
+ * @param c:      The character.
+ *
+ * @returns `false` if the character is not valid here, otherwise `true`.
+ */
+static bool json_process(JsonParser* parser, char c) {
+    
+    switch (parser->state) {
+        case STATE_VALUE:
+            if (json_is_space(c)) return true;
+            parser->token_length = 0;
+            parser->token[0] = 0;
+            parser->truncated = false;
+            
+            // Close an empty array
+            if (c == ']' && parser->is_empty) return json_end_value(parser);
+            parser->is_empty = false;
+            
+            if (c == '{' || c == '[') {
+                if (parser->depth == JSON_MAX_DEPTH) return false;
+                parser->stack[parser->depth++] = c;
+                parser->state = (c == '{') ? STATE_KEY : STATE_VALUE;
+                parser->key[0] = 0;
+                parser->is_empty = true;
+                return true;
+            }
+            
+            if (c == '"') {
+                parser->in_key = false;
+                parser->state = STATE_STRING;
+                return true;
+            }
+            
+            if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+                json_add_to_token(parser, c);
+                parser->state = STATE_LITERAL;
+                return true;
+            }
+            
+            return false;
+        
+        case STATE_KEY:
+            if (json_is_space(c)) return true;
+            if (c == '}' && parser->is_empty) return json_end_value(parser);
+            parser->is_empty = false;
+            if (c != '"') return false;
+            parser->token_length = 0;
+            parser->token[0] = 0;
+            parser->truncated = false;
+            parser->in_key = true;
+            parser->state = STATE_STRING;
+            return true;
+        
+        case STATE_COLON:
+            if (json_is_space(c)) return true;
+            if (c != ':') return false;
+            parser->state = STATE_VALUE;
+            return true;
+        
+        case STATE_STRING:
+            if (c == '\\') {
+                parser->state = STATE_ESCAPE;
+                return true;
+            }
+            
+            if (c == '"') {
+                if (parser->in_key) {
+                    memcpy(parser->key, parser->token, parser->token_length + 1);
+                    parser->state = STATE_COLON;
+                    return true;
+                }
+                
+                if (parser->handler) parser->handler(parser->key, JSON_TYPE_STRING, parser->token, parser->depth, parser->context);
+                parser->state = parser->depth == 0 ? STATE_DONE : STATE_AFTER_VALUE;
+                return true;
+            }
+            
+            if ((uint8_t)c < 0x20) return false;
+            json_add_to_token(parser, c);
+            return true;
+        
+        case STATE_ESCAPE:
+            parser->state = STATE_STRING;
+            switch (c) {
+                case '"':
+                case '\\':
+                case '/':
+                    json_add_to_token(parser, c);
+                    return true;
+                case 'b':
+                case 'f':
+                case 'n':
+                case 'r':
+                case 't':
+                    json_add_to_token(parser, ' ');
+                    return true;
+                case 'u':
+                    // Non-ASCII code points are replaced, not decoded
+                    json_add_to_token(parser, '?');
+                    parser->escape_count = 0;
+                    parser->state = STATE_UNICODE;
+                    return true;
+                default:
+                    return false;
+            }
+        
+        case STATE_UNICODE:
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))) return false;
+            if (++parser->escape_count == 4) parser->state = STATE_STRING;
+            return true;
+        
+        case STATE_LITERAL:
+            if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '.' || c == '-' || c == '+' || c == 'E') {
+                json_add_to_token(parser, c);
+                return true;
+            }
+            
+            // Any other character ends the literal, and is then
+            // processed as whatever follows the value
+            if (!json_end_literal(parser)) return false;
+            return json_process(parser, c);
+        
+        case STATE_AFTER_VALUE:
+            if (json_is_space(c)) return true;
+            if (parser->depth == 0) return false;
+            
+            if (c == ',') {
+                parser->state = (parser->stack[parser->depth - 1] == '{') ? STATE_KEY : STATE_VALUE;
+                return true;
+            }
+            
+            if ((c == '}' && parser->stack[parser->depth - 1] == '{') || (c == ']' && parser->stack[parser->depth - 1] == '[')) {
+                return json_end_value(parser);
+            }
+            
+            return false;
+        
+        case STATE_DONE:
+            return json_is_space(c);
+        
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * @brief Validate and report a completed number, `true`, `false` or `null`.
+ *
+ * @param parser: A pointer to the parser.
+ *
+ * @returns `false` if the literal is malformed, otherwise `true`.
+ */
+static bool json_end_literal(JsonParser* parser) {
+    
+    uint8_t type = JSON_TYPE_NUMBER;
+    if (strcmp(parser->token, "true") == 0 || strcmp(parser->token, "false") == 0) {
+        type = JSON_TYPE_BOOL;
+    } else if (strcmp(parser->token, "null") == 0) {
+        type = JSON_TYPE_NULL;
+    } else if (!json_is_number(parser->token)) {
+        return false;
+    }
+    
+    if (parser->handler) parser->handler(parser->key, type, parser->token, parser->depth, parser->context);
+    parser->state = parser->depth == 0 ? STATE_DONE : STATE_AFTER_VALUE;
+    return true;
+}
+
+
+/**
+ * @brief Close the innermost object or array.
+ *
+ * @param parser: A pointer to the parser.
+ *
+ * @returns `true`.
+ */
+static bool json_end_value(JsonParser* parser) {
+    
+    parser->depth--;
+    parser->key[0] = 0;
+    parser->state = parser->depth == 0 ? STATE_DONE : STATE_AFTER_VALUE;
+    return true;
+}
+
+
+/**
+ * @brief Add a character to the current token, discarding it and
+ *        flagging the token as truncated if the token is full.
+ *
+ * @param parser: A pointer to the parser.
+ * @param c:      The character.
+ */
+static void json_add_to_token(JsonParser* parser, char c) {
+    
+    if (parser->token_length < JSON_MAX_TOKEN_LEN) {
+        parser->token[parser->token_length++] = c;
+        parser->token[parser->token_length] = 0;
+    } else {
+        parser->truncated = true;
+    }
+}
+
+
+/**
+ * @brief Check a token is a well-formed JSON number.
+ *
+ * @param text: The token.
+ *
+ * @returns `true` if the token is a number, otherwise `false`.
+ */
+static bool json_is_number(const char* text) {
+    
+    if (*text == '-') text++;
+    if (*text < '0' || *text > '9') return false;
+    
+    // No leading zeros
+    if (*text == '0' && text[1] >= '0' && text[1] <= '9') return false;
+    while (*text >= '0' && *text <= '9') text++;
+    
+    if (*text == '.') {
+        text++;
+        if (*text < '0' || *text > '9') return false;
+        while (*text >= '0' && *text <= '9') text++;
+    }
+    
+    if (*text == 'e' || *text == 'E') {
+        text++;
+        if (*text == '+' || *text == '-') text++;
+        if (*text < '0' || *text > '9') return false;
+        while (*text >= '0' && *text <= '9') text++;
+    }
+    
+    return *text == 0;
+}
+
+
+/**
+ * @brief Check for JSON whitespace.
+ *
+ * @param c: The character.
+ *
+ * @returns `true` if the character is whitespace, otherwise `false`.
+ */
+static bool json_is_space(char c) {
+    
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
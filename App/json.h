@@ -0,0 +1,69 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _JSON_H_
+#define _JSON_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     JSON_MAX_DEPTH              8
+#define     JSON_MAX_TOKEN_LEN          31
+
+#define     JSON_TYPE_NULL              0
+#define     JSON_TYPE_BOOL              1
+#define     JSON_TYPE_NUMBER            2
+#define     JSON_TYPE_STRING            3
+
+
+/*
+ * STRUCTURES
+ */
+// Receives each scalar value as it completes. `key` is the value's
+// member name, or "" for array elements and top-level values.
+// `depth` is 1 for members of the top-level object. The parser's
+// `truncated` flag is set if `value` was cut short
+typedef void (*JsonValueHandler)(const char* key, uint8_t type, const char* value, uint8_t depth, void* context);
+
+typedef struct {
+    JsonValueHandler    handler;
+    void*               context;
+    uint8_t             state;
+    uint8_t             depth;
+    char                stack[JSON_MAX_DEPTH];
+    bool                in_key;
+    bool                is_empty;
+    bool                error;
+    uint8_t             escape_count;
+    uint8_t             token_length;
+    bool                truncated;
+    char                token[JSON_MAX_TOKEN_LEN + 1];
+    char                key[JSON_MAX_TOKEN_LEN + 1];
+} JsonParser;           // Record for an incremental parse in progress
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        json_init(JsonParser* parser, JsonValueHandler handler, void* context);
+bool        json_feed(JsonParser* parser, const uint8_t* data, uint32_t length);
+bool        json_finish(JsonParser* parser);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _JSON_H_
@@ -0,0 +1,108 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * GLOBALS
+ */
+// Bucket upper bounds in µs, inclusive. The syscalls take tens to
+// hundreds of µs; responses take hundreds of ms. The last bucket takes
+// everything longer, which includes requests that hit HTTP_REQUEST_TIMEOUT_MS
+static const uint32_t bucket_limits[LATENCY_BUCKET_COUNT - 1] = {
+    10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000,
+    50000, 100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000
+};
+
+static const char* const stage_names[LATENCY_STAGE_COUNT] = {
+    "open", "send", "first byte", "process", "close"
+};
+
+static LatencyHistogram histograms[LATENCY_STAGE_COUNT] = { 0 };
+
+
+/**
+ * @brief Add a timing to a stage's histogram.
+ *
+ * @param stage:       The stage, eg. LATENCY_STAGE_OPEN.
+ * @param duration_us: How long the stage took.
+ */
+void latency_record(uint8_t stage, uint32_t duration_us) {
+    
+    if (stage >= LATENCY_STAGE_COUNT) return;
+    
+    LatencyHistogram* histogram = &histograms[stage];
+    if (histogram->count == 0 || duration_us < histogram->min_us) histogram->min_us = duration_us;
+    if (duration_us > histogram->max_us) histogram->max_us = duration_us;
+    histogram->count++;
+    histogram->total_us += duration_us;
+    
+    uint32_t bucket = 0;
+    while (bucket < LATENCY_BUCKET_COUNT - 1 && duration_us > bucket_limits[bucket]) bucket++;
+    histogram->buckets[bucket]++;
+}
+
+
+/**
+ * @brief Get a stage's histogram.
+ *
+ * @param stage: The stage, eg. LATENCY_STAGE_OPEN.
+ * @param data:  Pointer to a LatencyHistogram structure.
+ *               (see latency.h)
+ */
+void latency_get_histogram(uint8_t stage, LatencyHistogram* data) {
+    
+    if (stage < LATENCY_STAGE_COUNT) *data = histograms[stage];
+}
+
+
+/**
+ * @brief Estimate a percentile from a histogram.
+ *
+ * The result is the upper bound of the bucket the percentile falls in,
+ * capped at the longest timing seen, so it errs on the long side -- which
+ * is the safe side when choosing a time-out.
+ *
+ * @param histogram: A pointer to the histogram.
+ * @param percent:   The percentile, 1-100.
+ *
+ * @returns The estimate in µs, or 0 if there are no timings.
+ */
+uint32_t latency_percentile(const LatencyHistogram* histogram, uint32_t percent) {
+    
+    if (histogram->count == 0) return 0;
+    
+    // The rank of the timing we want, rounded up
+    uint32_t rank = (uint32_t)(((uint64_t)histogram->count * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint32_t bucket = 0 ; bucket < LATENCY_BUCKET_COUNT - 1 ; ++bucket) {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank) return bucket_limits[bucket] < histogram->max_us ? bucket_limits[bucket] : histogram->max_us;
+    }
+    
+    return histogram->max_us;
+}
+
+
+/**
+ * @brief Log a summary line for each stage that has timings.
+ */
+void latency_log_summary(void) {
+    
+    for (uint8_t stage = 0 ; stage < LATENCY_STAGE_COUNT ; ++stage) {
+        const LatencyHistogram* histogram = &histograms[stage];
+        if (histogram->count == 0) continue;
+        
+        server_log("HTTP %s latency: %lu samples, min %lu us, mean %lu us, p50 %lu us, p90 %lu us, p99 %lu us, max %lu us",
+                   stage_names[stage], histogram->count, histogram->min_us,
+                   (uint32_t)(histogram->total_us / histogram->count),
+                   latency_percentile(histogram, 50), latency_percentile(histogram, 90),
+                   latency_percentile(histogram, 99), histogram->max_us);
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     LATENCY_BUCKET_COUNT        20
+
+// HTTP request stages
+#define     LATENCY_STAGE_OPEN          0       // `mvOpenChannel()` call
+#define     LATENCY_STAGE_SEND          1       // `mvSendHttpRequest()` call
+#define     LATENCY_STAGE_FIRST_BYTE    2       // Request sent to response readable
+#define     LATENCY_STAGE_PROCESS       3       // Response read and handled
+#define     LATENCY_STAGE_CLOSE         4       // `mvCloseChannel()` call
+#define     LATENCY_STAGE_COUNT         5
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    count;
+    uint32_t    min_us;
+    uint32_t    max_us;
+    uint64_t    total_us;
+    uint32_t    buckets[LATENCY_BUCKET_COUNT];
+} LatencyHistogram;     // Record for one stage's timings
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        latency_record(uint8_t stage, uint32_t duration_us);
+void        latency_get_histogram(uint8_t stage, LatencyHistogram* data);
+uint32_t    latency_percentile(const LatencyHistogram* histogram, uint32_t percent);
+void        latency_log_summary(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _LATENCY_H_
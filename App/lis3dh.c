@@ -16,17 +16,64 @@ static void     _set_reg(uint8_t reg, uint8_t val);
 static void     _set_reg_bit(uint8_t reg, uint8_t bit, bool state);
 static uint8_t  _get_reg(uint8_t reg);
 static void     _get_multi_reg(uint8_t reg, uint8_t* result, uint8_t num_bytes);
+static void     _set_multi_reg(uint8_t reg, const uint8_t* values, uint8_t num_bytes);
+static bool     _is_shadowed(uint8_t reg);
+static bool     _take_bus(void);
+static bool     _begin_update(void);
+static void     _end_update(void);
+static void     _flush_shadow(void);
+static bool     _read_shadowed(uint8_t* buffer);
+static void     _update_scale(void);
+static uint8_t  _mg_to_threshold(uint32_t threshold);
 
 
 /*
  * GLOBALS
  */
-extern I2C_HandleTypeDef i2c;
-
 // Data
 static uint8_t _local_mode = LIS3DH_MODE_NORMAL;
 static uint8_t _local_range = 0;
 
+// Accelerometer sensitivity in mg per digit, by mode then by range (±2, 4, 8, 16G),
+// and the shift that takes a left-justified count down to the mode's resolution.
+// See the LIS3DH datasheet, table 4
+static const uint8_t mg_per_digit[3][4] = {
+    {  4,  8, 16,  48 },        // LIS3DH_MODE_NORMAL: 10-bit
+    { 16, 32, 64, 192 },        // LIS3DH_MODE_LOW_POWER: 8-bit
+    {  1,  2,  4,  12 }         // LIS3DH_MODE_HIGH_RESOLUTION: 12-bit
+};
+static const uint8_t mode_shift[3] = { 6, 8, 4 };
+
+// The scale for the current mode and range, set by `_update_scale()`
+static uint8_t _scale_shift = 6;
+static uint8_t _scale_mg = 4;
+
+// Write-through copy of the control registers, indexed from LIS3DH_SHADOW_FIRST.
+// Only the registers in `shadow_regs` are held: the others in the range are
+// outputs or status registers, some of which clear when read, so they always
+// come from the device. Writes made during an update are held as dirty and
+// then written in bursts when the update ends
+#define SHADOW_BIT(reg)     (1UL << ((reg) - LIS3DH_SHADOW_FIRST))
+
+static const uint32_t shadow_regs = SHADOW_BIT(LIS3DH_TEMP_CFG_REG)
+                                  | SHADOW_BIT(LIS3DH_CTRL_REG1) | SHADOW_BIT(LIS3DH_CTRL_REG2)
+                                  | SHADOW_BIT(LIS3DH_CTRL_REG3) | SHADOW_BIT(LIS3DH_CTRL_REG4)
+                                  | SHADOW_BIT(LIS3DH_CTRL_REG5) | SHADOW_BIT(LIS3DH_CTRL_REG6)
+                                  | SHADOW_BIT(LIS3DH_FIFO_CTRL_REG)
+                                  | SHADOW_BIT(LIS3DH_INT1_CFG) | SHADOW_BIT(LIS3DH_INT1_THS)
+                                  | SHADOW_BIT(LIS3DH_INT1_DURATION)
+                                  | SHADOW_BIT(LIS3DH_CLICK_CFG) | SHADOW_BIT(LIS3DH_CLICK_THS)
+                                  | SHADOW_BIT(LIS3DH_TIME_LIMIT) | SHADOW_BIT(LIS3DH_TIME_LATENCY)
+                                  | SHADOW_BIT(LIS3DH_TIME_WINDOW);
+
+static uint8_t  shadow[LIS3DH_SHADOW_SIZE] = { 0 };
+static uint32_t shadow_dirty = 0;
+static bool     shadow_valid = false;
+static uint8_t  update_depth = 0;
+
+// Operations skipped because the bus couldn't be taken
+static uint32_t skipped_ops = 0;
+
 
 /**
     @brief  Check the device is connected and operational.
@@ -59,8 +106,10 @@ bool LIS3DH_init(void) {
  */
 void LIS3DH_enable_ADC(bool state) {
     
+    if (!_begin_update()) return;
     _set_reg_bit(LIS3DH_TEMP_CFG_REG, 7, state ? 1 : 0);
     _set_reg_bit(LIS3DH_CTRL_REG4,    7, state ? 1 : 0);
+    _end_update();
 }
 
 
@@ -71,20 +120,19 @@ void LIS3DH_enable_ADC(bool state) {
  *
  * @param adc_line: The required ADC line.
  *
- * @returns The ADC value.
+ * @returns The ADC input in millivolts.
  */
-double LIS3DH_read_ADC(uint8_t adc_line) {
+int32_t LIS3DH_read_ADC(uint8_t adc_line) {
     
     uint8_t reg = (adc_line << 1) + 6;
     uint8_t read[2] = {0};
     _get_multi_reg(reg, read, 2);
 
-    // Shift and sign extend
-    double val = (double)((((read[0] >> 6) | (read[1] << 2)) << 22) >> 22);
-    val /= 512.0; // In low-power mode, there will be lower resolution
+    // Shift and sign extend. In low-power mode, there will be lower resolution
+    int32_t val = (int32_t)((uint32_t)((read[0] >> 6) | (read[1] << 2)) << 22) >> 22;
 
-    // Affine transformation to map to appropriate voltage
-    return (val * 0.4) + 1.2;
+    // Map ±512 counts onto the 800-1600mV input range
+    return LIS3DH_ADC_MID_MV + (val * LIS3DH_ADC_SPAN_MV) / 1024;
 }
 
 
@@ -101,6 +149,7 @@ double LIS3DH_read_ADC(uint8_t adc_line) {
  */
 void LIS3DH_enable_accel(bool enable) {
     
+    if (!_begin_update()) return;
     uint8_t val = _get_reg(LIS3DH_CTRL_REG1);
     if (enable) {
         val |= 0x07;
@@ -108,28 +157,72 @@ void LIS3DH_enable_accel(bool enable) {
         val &= 0xF8;
     }
     _set_reg(LIS3DH_CTRL_REG1, val);
+    _end_update();
 }
 
 
 /**
- * @brief Read data from the Accelerometer.
+ * @brief Read data from the Accelerometer in mG.
  *
  * @param result: A pointer to an AccelResult struct.
  */
 void LIS3DH_get_accel(AccelResult* result) {
     
+    AccelRaw raw;
+    LIS3DH_get_accel_raw(&raw);
+
+    result->x = LIS3DH_raw_to_mg(raw.x);
+    result->y = LIS3DH_raw_to_mg(raw.y);
+    result->z = LIS3DH_raw_to_mg(raw.z);
+}
+
+
+/**
+ * @brief Read data from the Accelerometer as the sensor reports it.
+ *
+ * The counts are left-justified 16-bit two's complement values,
+ * so they can be stored and transmitted without any loss of precision.
+ *
+ * @param result: A pointer to an AccelRaw struct.
+ */
+void LIS3DH_get_accel_raw(AccelRaw* result) {
+    
     uint8_t reading[6] = {0};
-    _get_multi_reg(LIS3DH_OUT_X_L_INCR, reading, 6);
+    _get_multi_reg(LIS3DH_OUT_X_L, reading, 6);
+
+    result->x = (int16_t)(reading[0] | (reading[1] << 8));
+    result->y = (int16_t)(reading[2] | (reading[3] << 8));
+    result->z = (int16_t)(reading[4] | (reading[5] << 8));
+}
 
-    // Read and sign extend the raw data
-    result->x = ((reading[0] | (reading[1] << 8)) << 16) >> 16;
-    result->y = ((reading[2] | (reading[3] << 8)) << 16) >> 16;
-    result->z = ((reading[4] | (reading[5] << 8)) << 16) >> 16;
 
-    // Multiply by full-scale range to return in G
-    result->x = (result->x / 32000.0) * _local_range;
-    result->y = (result->y / 32000.0) * _local_range;
-    result->z = (result->z / 32000.0) * _local_range;
+/**
+ * @brief Convert a raw axis reading to mG at the current mode and full-scale range.
+ *
+ * @param count: A count from `LIS3DH_get_accel_raw()`.
+ *
+ * @returns The acceleration in mG.
+ */
+int32_t LIS3DH_raw_to_mg(int16_t count) {
+    
+    // NOTE Relies on right-shifting a negative value being arithmetic, as it is in GCC
+    return (int32_t)(count >> _scale_shift) * _scale_mg;
+}
+
+
+/**
+ * @brief Convert a raw axis reading to G at the current mode and full-scale range.
+ *
+ * This is for signal processing, which works in single precision so
+ * it runs on the FPU. Use `LIS3DH_raw_to_mg()` for display and upload.
+ *
+ * @param count: A count from `LIS3DH_get_accel_raw()`.
+ *
+ * @returns The acceleration in G.
+ */
+float LIS3DH_raw_to_g(int16_t count) {
+    
+    return (float)LIS3DH_raw_to_mg(count) * (1.0f / LIS3DH_MG_PER_G);
 }
 
 
@@ -150,6 +243,8 @@ uint8_t LIS3DH_get_range(void) {
     } else {
         _local_range = 16;
     }
+
+    _update_scale();
     return _local_range;
 }
 
@@ -163,6 +258,7 @@ uint8_t LIS3DH_get_range(void) {
  */
 uint8_t LIS3DH_set_range(uint8_t rangeA) {
     
+    if (!_begin_update()) return _local_range;
     uint8_t val = _get_reg(LIS3DH_CTRL_REG4) & 0xCF;
     uint8_t range_bits = 0;
     if (rangeA <= 2) {
@@ -180,6 +276,8 @@ uint8_t LIS3DH_set_range(uint8_t rangeA) {
     }
 
     _set_reg(LIS3DH_CTRL_REG4, val | (range_bits << 4));
+    _end_update();
+    _update_scale();
     return _local_range;
 }
 
@@ -192,10 +290,11 @@ uint8_t LIS3DH_set_range(uint8_t rangeA) {
  *  The requested data rate will be rounded up to the closest supported rate
  *  and the actual data rate will be returned.
  *
- *  @returns The current range.
+ *  @returns The data rate set, or 0 if the bus couldn't be taken.
  */
 uint32_t LIS3DH_set_data_rate(uint32_t rate) {
     
+    if (!_begin_update()) return 0;
     uint8_t val = _get_reg(LIS3DH_CTRL_REG1) & 0x0F;
     bool normal_mode = (val < 8);
     if (rate == 0) {
@@ -235,6 +334,7 @@ uint32_t LIS3DH_set_data_rate(uint32_t rate) {
     }
 
     _set_reg(LIS3DH_CTRL_REG1, val);
+    _end_update();
     return rate;
 }
 
@@ -247,9 +347,12 @@ uint32_t LIS3DH_set_data_rate(uint32_t rate) {
  */
 void LIS3DH_set_mode(uint8_t mode) {
     
+    if (!_begin_update()) return;
     _set_reg_bit(LIS3DH_CTRL_REG1, 3, mode & 0x01);
     _set_reg_bit(LIS3DH_CTRL_REG4, 3, mode & 0x02);
     _local_mode = mode;
+    _end_update();
+    _update_scale();
 }
 
 
@@ -268,6 +371,8 @@ void LIS3DH_configure_high_pass_filter(uint8_t filters, uint8_t cutoff, uint8_t
  */
 void LIS3DH_configure_fifo(bool enable, uint8_t fifo_mode) {
     
+    if (!_begin_update()) return;
+
     // Enable/disable the FIFO
     _set_reg_bit(LIS3DH_CTRL_REG5, 6, enable ? 1 : 0);
 
@@ -282,6 +387,7 @@ void LIS3DH_configure_fifo(bool enable, uint8_t fifo_mode) {
         // Set mode to bypass
         _set_reg(LIS3DH_FIFO_CTRL_REG, val);
     }
+    _end_update();
 }
 
 
@@ -290,12 +396,14 @@ void LIS3DH_configure_fifo(bool enable, uint8_t fifo_mode) {
  *
  * @param enable:     Enable click interrupts (`true`) or disable them (`false`).
  * @param click_type: The type of click to monitor — see lis3dh.h.
- * @param threshold:  Inertial interrupts threshold in float Gs.
+ * @param threshold:  Inertial interrupts threshold in integer mG.
  * @param time_limit: Period to check for clicks in integer milliseconds.
  * @param latency:    Laterncy period in integer milliseconds.
  * @param window:     Measurement window in integer milliseconds.
  */
-void LIS3DH_configure_click_irq(bool enable, uint8_t click_type, float threshold, uint8_t time_limit, uint8_t latency, uint8_t window) {
+void LIS3DH_configure_click_irq(bool enable, uint8_t click_type, uint32_t threshold, uint8_t time_limit, uint8_t latency, uint8_t window) {
+
+    if (!_begin_update()) return;
 
     // Set the enable / disable flag
     _set_reg_bit(LIS3DH_CTRL_REG3, 7, enable ? 1 : 0);
@@ -304,6 +412,7 @@ void LIS3DH_configure_click_irq(bool enable, uint8_t click_type, float threshold
     // If the click interrupt is not disabled, clear LIS3DH_CLICK_CFG register and return
     if (!enable) {
         _set_reg(LIS3DH_CLICK_CFG, 0x00);
+        _end_update();
         return;
     }
 
@@ -312,18 +421,14 @@ void LIS3DH_configure_click_irq(bool enable, uint8_t click_type, float threshold
 
     // Set the LIS3DH_CLICK_THS register
     uint8_t latched_bit = _get_reg(LIS3DH_CLICK_THS) & 0x80;    // Get LIR_Click bit
-    if (threshold < 0) threshold *= -1.0;                       // Make sure we have a positive value
-    if (threshold > _local_range) threshold = (float)_local_range;     // Make sure it doesn't exceed the _range
-
-    uint32_t ithreshold = (uint32_t)((threshold / (float)_local_range) * 127);
-    _set_reg(LIS3DH_CLICK_THS, latched_bit | (ithreshold & 0x7F));
-
-    // Set the LIS3DH_TIME_LIMIT register (max time for a click)
-    _set_reg(LIS3DH_TIME_LIMIT, time_limit);
-    // Set the LIS3DH_TIME_LATENCY register (min time between clicks for double click)
-    _set_reg(LIS3DH_TIME_LATENCY, latency);
-    // Set the LIS3DH_TIME_WINDOW register (max time for double click)
-    _set_reg(LIS3DH_TIME_WINDOW, window);
+    _set_reg(LIS3DH_CLICK_THS, latched_bit | _mg_to_threshold(threshold));
+
+    // Set the LIS3DH_TIME_LIMIT (max time for a click), LIS3DH_TIME_LATENCY
+    // (min time between clicks for double click) and LIS3DH_TIME_WINDOW
+    // (max time for double click) registers in one burst
+    const uint8_t timing[3] = { time_limit, latency, window };
+    _set_multi_reg(LIS3DH_TIME_LIMIT, timing, 3);
+    _end_update();
 }
 
 
@@ -331,12 +436,12 @@ void LIS3DH_configure_click_irq(bool enable, uint8_t click_type, float threshold
  * @brief Configure the LIS3DH to assert the INT pin on falls.
  *
  * @param enable:     Latch (`true`) or unlatch (`false`) the interrupts.
- * @param threshold:  Inertial interrupts threshold in float Gs.
+ * @param threshold:  Inertial interrupts threshold in integer mG.
  * @param time_limit: Period to check for falls in integer milliseconds.
  * @param latency:    Laterncy period in integer milliseconds.
  * @param window:     Measurement window in integer milliseconds.
  */
-void LIS3DH_configure_free_fall_irq(bool enable, float threshold, uint8_t duration) {
+void LIS3DH_configure_free_fall_irq(bool enable, uint32_t threshold, uint8_t duration) {
     
     LIS3DH_configure_inertial_irq(enable, threshold, duration, LIS3DH_AOI | LIS3DH_X_LOW | LIS3DH_Y_LOW | LIS3DH_Z_LOW);
 }
@@ -346,31 +451,30 @@ void LIS3DH_configure_free_fall_irq(bool enable, float threshold, uint8_t durati
  * @brief Configure the LIS3DH to assert the INT pin on movement.
  *
  * @param enable:    Latch (`true`) or unlatch (`false`) the interrupts.
- * @param threshold: Inertial interrupts threshold in float Gs.
+ * @param threshold: Inertial interrupts threshold in integer mG.
  * @param duration:  Period to check for motion in integer milliseconds.
  * @param options:   Bitfield indicated when an interrupt will be triggered.
  */
-void LIS3DH_configure_inertial_irq(bool enable, float threshold, uint8_t duration, uint8_t options) {
+void LIS3DH_configure_inertial_irq(bool enable, uint32_t threshold, uint8_t duration, uint8_t options) {
     
+    if (!_begin_update()) return;
+
     // Set the enable flag
     _set_reg_bit(LIS3DH_CTRL_REG3, 6, enable ? 1 : 0);
 
     // If we're disabling the interrupt, don't set anything else
-    if (!enable) return;
-
-    // Clamp the threshold
-    if (threshold < 0) threshold = threshold * -1.0;    // Make sure we have a positive value
-    if (threshold > _local_range) threshold = (float)_local_range;        // Make sure it doesn't exceed the _range
-
-    // Set the threshold
-    uint32_t ithreshold = (uint32_t)((threshold / (float)_local_range) * 127);
-    _set_reg(LIS3DH_INT1_THS, (ithreshold & 0x7F));
+    if (!enable) {
+        _end_update();
+        return;
+    }
 
-    // Set the duration
-    _set_reg(LIS3DH_INT1_DURATION, duration & 0x7F);
+    // Set the threshold and the duration in one burst
+    const uint8_t values[2] = { _mg_to_threshold(threshold), duration & 0x7F };
+    _set_multi_reg(LIS3DH_INT1_THS, values, 2);
 
     // Set the options flags
     _set_reg(LIS3DH_INT1_CFG, options);
+    _end_update();
 }
 
 
@@ -382,21 +486,29 @@ void LIS3DH_configure_inertial_irq(bool enable, float threshold, uint8_t duratio
  */
 void LIS3DH_configure_irq_latching(bool enable) {
     
+    if (!_begin_update()) return;
     _set_reg_bit(LIS3DH_CTRL_REG5, 3, enable ? 1 : 0);
     _set_reg_bit(LIS3DH_CLICK_THS, 7, enable ? 1 : 0);
+    _end_update();
 }
 
 
 /**
  * @brief Get the LIS3dH's interrupt table.
  *
+ * If the bus can't be taken, no interrupts are reported. Latched
+ * interrupts stay latched, so they are reported by the next call.
+ *
  * @param data: Pointer to an InterruptTable structure.
  *              (see lis3dh.h)
  */
 void LIS3DH_get_interrupt_table(InterruptTable* data) {
     
+    memset(data, 0, sizeof(InterruptTable));
+    if (!_take_bus()) return;
     uint8_t int_1 = _get_reg(LIS3DH_INT1_SRC);
     uint8_t click = _get_reg(LIS3DH_CLICK_SRC);
+    I2C_end_batch();
     data->int_1 = (int_1 & 0x40) != 0;
     data->x_low = (int_1 & 0x01) != 0;
     data->x_high = (int_1 & 0x02) != 0;
@@ -410,6 +522,75 @@ void LIS3DH_get_interrupt_table(InterruptTable* data) {
 }
 
 
+/**
+ * @brief Set the FIFO watermark.
+ *
+ * The FIFO's watermark flag, and the watermark interrupt if enabled,
+ * are raised when the FIFO holds more than this many samples.
+ *
+ * @param level: The watermark, 0-31.
+ */
+void LIS3DH_set_fifo_watermark(uint8_t level) {
+    
+    if (!_begin_update()) return;
+    uint8_t val = _get_reg(LIS3DH_FIFO_CTRL_REG) & 0xE0;
+    _set_reg(LIS3DH_FIFO_CTRL_REG, val | (level & 0x1F));
+    _end_update();
+}
+
+
+/**
+ * @brief Enable/disable the FIFO watermark interrupt on INT1.
+ *
+ * @param enable: Assert INT1 at the watermark (`true`) or not (`false`).
+ */
+void LIS3DH_configure_watermark_irq(bool enable) {
+    
+    _set_reg_bit(LIS3DH_CTRL_REG3, 2, enable ? 1 : 0);
+}
+
+
+/**
+ * @brief Read every sample waiting in the FIFO.
+ *
+ * The samples are read in a single burst: in FIFO modes the
+ * register address wraps from OUT_Z_H back to OUT_X_L, so each
+ * six bytes read pops the next sample.
+ *
+ * @param samples:     The buffer to read into.
+ * @param max_samples: The buffer's size, in samples.
+ * @param overrun:     Set to `true` if the FIFO had filled, so
+ *                     samples may have been lost, otherwise `false`.
+ *
+ * @returns The number of samples read, or 0 if the bus couldn't be taken.
+ */
+uint8_t LIS3DH_read_fifo(AccelRaw* samples, uint8_t max_samples, bool* overrun) {
+    
+    static uint8_t reading[LIS3DH_FIFO_SIZE * 6];
+    
+    *overrun = false;
+    if (!_take_bus()) return 0;
+    FifoState state;
+    LIS3DH_get_fifo_stats(&state);
+    *overrun = state.overrun;
+    
+    uint8_t count = state.unread;
+    if (count > max_samples) count = max_samples;
+    if (count > LIS3DH_FIFO_SIZE) count = LIS3DH_FIFO_SIZE;
+    if (count > 0 && I2C_read_regs(LIS3DH_ADDR, LIS3DH_OUT_X_L | LIS3DH_AUTO_INCREMENT, reading, count * 6, 100) != HAL_OK) count = 0;
+    I2C_end_batch();
+    
+    for (uint8_t i = 0 ; i < count ; ++i) {
+        const uint8_t* sample = &reading[i * 6];
+        samples[i].x = (int16_t)(sample[0] | (sample[1] << 8));
+        samples[i].y = (int16_t)(sample[2] | (sample[3] << 8));
+        samples[i].z = (int16_t)(sample[4] | (sample[5] << 8));
+    }
+    
+    return count;
+}
+
+
 /**
  * @brief Get the LIS3dH's FIFO status.
  *
@@ -426,29 +607,78 @@ void LIS3DH_get_fifo_stats(FifoState* data) {
 }
 
 
+/**
+ * @brief Reload the register shadow from the device.
+ *
+ * Use this if the device's registers may have been changed by
+ * something other than this driver.
+ *
+ * @returns `true` if the registers were read, otherwise `false`.
+ */
+bool LIS3DH_resync_registers(void) {
+    
+    uint8_t buffer[LIS3DH_SHADOW_SIZE] = { 0 };
+    
+    if (!_begin_update()) return false;
+    bool is_ok = _read_shadowed(buffer);
+    if (is_ok) {
+        memcpy(shadow, buffer, sizeof(shadow));
+        shadow_dirty = 0;
+        shadow_valid = true;
+        LIS3DH_get_range();
+    }
+    
+    _end_update();
+    return is_ok;
+}
+
+
+/**
+ * @brief Check the device's control registers against the shadow.
+ *
+ * Catches registers lost to a sensor brown-out or reset.
+ *
+ * @param restore: Write the shadow's value to any register that differs (`true`)
+ *                 or just count them (`false`).
+ *
+ * @returns The number of registers that differ, or 0 if there's
+ *          no valid shadow to check against, the bus couldn't be
+ *          taken or the read failed.
+ */
+uint8_t LIS3DH_verify_registers(bool restore) {
+    
+    uint8_t buffer[LIS3DH_SHADOW_SIZE] = { 0 };
+    uint8_t mismatches = 0;
+    
+    if (!_begin_update()) return 0;
+    if (shadow_valid && _read_shadowed(buffer)) {
+        for (uint8_t i = 0 ; i < LIS3DH_SHADOW_SIZE ; ++i) {
+            if ((shadow_regs & (1UL << i)) == 0 || buffer[i] == shadow[i]) continue;
+            mismatches++;
+            if (restore) shadow_dirty |= (1UL << i);
+        }
+    }
+    
+    _end_update();
+    return mismatches;
+}
+
+
 /**
  * @brief Set default values for registers.
  */
 void LIS3DH_reset(void) {
     
-    _set_reg(LIS3DH_CTRL_REG1, 0x07);
-    _set_reg(LIS3DH_CTRL_REG2, 0x00);
-    _set_reg(LIS3DH_CTRL_REG3, 0x00);
-    _set_reg(LIS3DH_CTRL_REG4, 0x00); // Sets range to default
-    _set_reg(LIS3DH_CTRL_REG5, 0x00);
-    _set_reg(LIS3DH_CTRL_REG6, 0x00);
-    _set_reg(LIS3DH_INT1_CFG, 0x00);
-    _set_reg(LIS3DH_INT1_THS, 0x00);
-    _set_reg(LIS3DH_INT1_DURATION, 0x00);
-    _set_reg(LIS3DH_CLICK_CFG, 0x00);
-    _set_reg(LIS3DH_CLICK_THS, 0x00);
-    _set_reg(LIS3DH_TIME_LIMIT, 0x00);
-    _set_reg(LIS3DH_TIME_LATENCY, 0x00);
-    _set_reg(LIS3DH_TIME_WINDOW, 0x00);
-    _set_reg(LIS3DH_FIFO_CTRL_REG, 0x00);
-    _set_reg(LIS3DH_TEMP_CFG_REG, 0x00);
-
-    // Reads the default range from register and + sets local _local_range property
+    // Seed the shadow with the defaults and write all of it:
+    // this is what makes the shadow valid
+    if (!_begin_update()) return;
+    memset(shadow, 0x00, sizeof(shadow));
+    shadow[LIS3DH_CTRL_REG1 - LIS3DH_SHADOW_FIRST] = 0x07;
+    shadow_dirty = shadow_regs;
+    shadow_valid = true;
+    _end_update();
+
+    // Sets local _local_range property from the default range
     LIS3DH_get_range();
 }
 
@@ -468,14 +698,24 @@ uint8_t LIS3DH_get_device_id(void) {
 
 static void _set_reg(uint8_t reg, uint8_t val) {
     
-    uint8_t send_data[2] = {0};
-    send_data[0] = reg;
-    send_data[1] = val;
-    HAL_I2C_Master_Transmit(&i2c, LIS3DH_ADDR << 1, send_data, 2, 100);
+    if (!_is_shadowed(reg)) {
+        I2C_write_regs(LIS3DH_ADDR, reg, &val, 1, 100);
+        return;
+    }
+    
+    // Writes that don't change a known value are dropped
+    uint32_t bit = SHADOW_BIT(reg);
+    uint8_t* value = &shadow[reg - LIS3DH_SHADOW_FIRST];
+    if (shadow_valid && (shadow_dirty & bit) == 0 && *value == val) return;
+    
+    *value = val;
+    shadow_dirty |= bit;
+    if (update_depth == 0) _flush_shadow();
 }
 
 static void _set_reg_bit(uint8_t reg, uint8_t bit, bool state) {
     
+    if (!_begin_update()) return;
     uint8_t val = _get_reg(reg);
     
     if (state) {
@@ -485,18 +725,136 @@ static void _set_reg_bit(uint8_t reg, uint8_t bit, bool state) {
     }
     
     _set_reg(reg, val);
+    _end_update();
 }
 
 static uint8_t _get_reg(uint8_t reg) {
     
+    if (_is_shadowed(reg) && (shadow_valid || (shadow_dirty & SHADOW_BIT(reg)) != 0)) {
+        return shadow[reg - LIS3DH_SHADOW_FIRST];
+    }
+    
     uint8_t result = 0;
-    HAL_I2C_Master_Transmit(&i2c, LIS3DH_ADDR << 1, &reg,    1, 100);
-    HAL_I2C_Master_Receive(&i2c,  LIS3DH_ADDR << 1, &result, 1, 100);
+    I2C_read_regs(LIS3DH_ADDR, reg, &result, 1, 100);
     return result;
 }
 
 static void _get_multi_reg(uint8_t reg, uint8_t* result, uint8_t num_bytes) {
     
-    HAL_I2C_Master_Transmit(&i2c, LIS3DH_ADDR << 1, &reg,   1,         100);
-    HAL_I2C_Master_Receive(&i2c,  LIS3DH_ADDR << 1, result, num_bytes, 100);
+    I2C_read_regs(LIS3DH_ADDR, reg | LIS3DH_AUTO_INCREMENT, result, num_bytes, 100);
+}
+
+static void _set_multi_reg(uint8_t reg, const uint8_t* values, uint8_t num_bytes) {
+    
+    if (!_begin_update()) return;
+    for (uint8_t i = 0 ; i < num_bytes ; ++i) _set_reg(reg + i, values[i]);
+    _end_update();
+}
+
+static bool _is_shadowed(uint8_t reg) {
+    
+    return reg >= LIS3DH_SHADOW_FIRST && reg <= LIS3DH_SHADOW_LAST && (shadow_regs & SHADOW_BIT(reg)) != 0;
+}
+
+// Take the bus for a series of transfers. If another task holds it for
+// longer than I2C_BATCH_TIMEOUT_MS, the operation is counted and logged,
+// and must be skipped: the caller doesn't own the bus
+static bool _take_bus(void) {
+    
+    if (I2C_begin_batch(LIS3DH_ADDR, I2C_BATCH_TIMEOUT_MS)) return true;
+    
+    skipped_ops++;
+    server_error("LIS3DH operation skipped, I2C bus busy (%lu skipped)", skipped_ops);
+    return false;
+}
+
+// Hold the bus, and hold back shadowed register writes until the
+// matching `_end_update()`, so they go out as bursts. Updates nest.
+// If the bus can't be taken, skip the update without `_end_update()`
+static bool _begin_update(void) {
+    
+    if (!_take_bus()) return false;
+    update_depth++;
+    return true;
+}
+
+static void _end_update(void) {
+    
+    if (update_depth > 0 && --update_depth == 0) _flush_shadow();
+    I2C_end_batch();
+}
+
+// Write the dirty registers, one burst per run. Once the shadow is valid,
+// a run carries on over up to LIS3DH_SHADOW_MAX_BRIDGE clean registers
+// to reach the next dirty one, as rewriting a register costs less than
+// another transaction. A run never spans a register outside the shadow.
+// Registers stay dirty if their write fails, so the next flush retries them
+static void _flush_shadow(void) {
+    
+    uint8_t index = 0;
+    while (shadow_dirty != 0 && index < LIS3DH_SHADOW_SIZE) {
+        if ((shadow_dirty & (1UL << index)) == 0) {
+            index++;
+            continue;
+        }
+        
+        uint8_t end = index + 1;
+        for (uint8_t next = end ; next < LIS3DH_SHADOW_SIZE && (shadow_regs & (1UL << next)) != 0 ; ++next) {
+            if ((shadow_dirty & (1UL << next)) != 0) {
+                end = next + 1;
+            } else if (!shadow_valid || next + 1 - end > LIS3DH_SHADOW_MAX_BRIDGE) {
+                break;
+            }
+        }
+        
+        uint8_t reg = LIS3DH_SHADOW_FIRST + index;
+        if (I2C_write_regs(LIS3DH_ADDR, reg | LIS3DH_AUTO_INCREMENT, &shadow[index], end - index, 100) == HAL_OK) {
+            shadow_dirty &= ~(((1UL << (end - index)) - 1) << index);
+        }
+        
+        index = end;
+    }
+}
+
+// Read the shadowed registers from the device, one burst per run, into
+// a buffer laid out like the shadow
+static bool _read_shadowed(uint8_t* buffer) {
+    
+    bool is_ok = true;
+    uint8_t index = 0;
+    while (index < LIS3DH_SHADOW_SIZE) {
+        if ((shadow_regs & (1UL << index)) == 0) {
+            index++;
+            continue;
+        }
+        
+        uint8_t end = index + 1;
+        while (end < LIS3DH_SHADOW_SIZE && (shadow_regs & (1UL << end)) != 0) end++;
+        
+        uint8_t reg = LIS3DH_SHADOW_FIRST + index;
+        if (I2C_read_regs(LIS3DH_ADDR, reg | LIS3DH_AUTO_INCREMENT, &buffer[index], end - index, 100) != HAL_OK) is_ok = false;
+        index = end;
+    }
+    
+    return is_ok;
+}
+
+// Pick the count scale for the current mode and range. The LP and HR
+// bits can't both be set, so any other mode is treated as normal
+static void _update_scale(void) {
+    
+    uint8_t mode = _local_mode <= LIS3DH_MODE_HIGH_RESOLUTION ? _local_mode : LIS3DH_MODE_NORMAL;
+    uint8_t range_index = 0;
+    while (range_index < 3 && (2 << range_index) < _local_range) range_index++;
+    _scale_shift = mode_shift[mode];
+    _scale_mg = mg_per_digit[mode][range_index];
+}
+
+// Convert a threshold in mG to a 7-bit threshold register value,
+// where full scale is the current range
+static uint8_t _mg_to_threshold(uint32_t threshold) {
+    
+    uint32_t range_mg = (uint32_t)_local_range * LIS3DH_MG_PER_G;
+    if (threshold > range_mg) threshold = range_mg;
+    return (uint8_t)((threshold * 127) / range_mg) & 0x7F;
 }
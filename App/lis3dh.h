@@ -16,6 +16,9 @@
 // Sensor I2C address
 #define LIS3DH_ADDR                         0x19
 
+// Set in a register address to step through registers on multi-byte access
+#define LIS3DH_AUTO_INCREMENT               0x80
+
 // Register addresses
 #define LIS3DH_TEMP_CFG_REG                 0x1F // Enable temp/ADC
 #define LIS3DH_CTRL_REG1                    0x20 // Data rate, normal/low power mode, enable xyz axis
@@ -76,6 +79,7 @@
 #define LIS3DH_FIFO_FIFO_MODE               0x40
 #define LIS3DH_FIFO_STREAM_MODE             0x80
 #define LIS3DH_FIFO_STREAM_TO_FIFO_MODE     0xC0
+#define LIS3DH_FIFO_SIZE                    32          // NOTE Size in samples, not bytes
 
 // Click Detection values
 #define LIS3DH_SINGLE_CLICK                 0x15
@@ -89,15 +93,32 @@
 #define LIS3DH_ADC2                         0x02
 #define LIS3DH_ADC3                         0x03
 
+// Fixed-point scales: accelerations are in mG, ADC inputs in mV
+#define LIS3DH_MG_PER_G                     1000
+#define LIS3DH_ADC_MID_MV                   1200
+#define LIS3DH_ADC_SPAN_MV                  800
+
+// Control register shadow
+#define LIS3DH_SHADOW_FIRST                 LIS3DH_TEMP_CFG_REG
+#define LIS3DH_SHADOW_LAST                  LIS3DH_TIME_WINDOW
+#define LIS3DH_SHADOW_SIZE                  (LIS3DH_SHADOW_LAST - LIS3DH_SHADOW_FIRST + 1)
+#define LIS3DH_SHADOW_MAX_BRIDGE            2
+
 
 /*
  * STRUCTURES
  */
 typedef struct {
-    double  x;
-    double  y;
-    double  z;
-} AccelResult;      // Record for accelerometer readings
+    int32_t x;
+    int32_t y;
+    int32_t z;
+} AccelResult;      // Record for accelerometer readings in mG
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} AccelRaw;         // Record for raw accelerometer counts
 
 typedef struct {
     bool    int_1;
@@ -116,7 +137,7 @@ typedef struct {
     bool    watermark;
     bool    overrun;
     bool    empty;
-    bool    unread;
+    uint8_t unread;
 } FifoState;        // Record for FIFO state info
 
 
@@ -131,22 +152,30 @@ extern "C" {
 bool        LIS3DH_init(void);
 void        LIS3DH_enable_accel(bool state);
 void        LIS3DH_enable_ADC(bool state);
-double      LIS3DH_read_ADC(uint8_t adc_line);
+int32_t     LIS3DH_read_ADC(uint8_t adc_line);
 void        LIS3DH_get_accel(AccelResult* result);
+void        LIS3DH_get_accel_raw(AccelRaw* result);
+int32_t     LIS3DH_raw_to_mg(int16_t count);
+float       LIS3DH_raw_to_g(int16_t count);
 uint8_t     LIS3DH_get_range(void);
 uint8_t     LIS3DH_set_range(uint8_t rangeA);
 uint32_t    LIS3DH_set_data_rate(uint32_t rate);
 void        LIS3DH_set_mode(uint8_t mode);
 void        LIS3DH_configure_high_pass_filter(uint8_t filters, uint8_t cutoff, uint8_t mode);
 void        LIS3DH_configure_fifo(bool state, uint8_t fifomode);
-void        LIS3DH_configure_click_irq(bool enable, uint8_t click_type, float threshold, uint8_t time_limit, uint8_t latency, uint8_t window);
+void        LIS3DH_set_fifo_watermark(uint8_t level);
+void        LIS3DH_configure_watermark_irq(bool enable);
+uint8_t     LIS3DH_read_fifo(AccelRaw* samples, uint8_t max_samples, bool* overrun);
+void        LIS3DH_configure_click_irq(bool enable, uint8_t click_type, uint32_t threshold, uint8_t time_limit, uint8_t latency, uint8_t window);
 void        LIS3DH_configure_irq_latching(bool enable);
 void        LIS3DH_get_interrupt_table(InterruptTable* data);
 void        LIS3DH_get_fifo_stats(FifoState* data);
-void        LIS3DH_configure_inertial_irq(bool enable, float threshold, uint8_t duration, uint8_t options);
-void        LIS3DH_configure_free_fall_irq(bool enable, float threshold, uint8_t duration);
+void        LIS3DH_configure_inertial_irq(bool enable, uint32_t threshold, uint8_t duration, uint8_t options);
+void        LIS3DH_configure_free_fall_irq(bool enable, uint32_t threshold, uint8_t duration);
 
 void        LIS3DH_reset(void);
+bool        LIS3DH_resync_registers(void);
+uint8_t     LIS3DH_verify_registers(bool restore);
 uint8_t     LIS3DH_get_device_id(void);
 
 
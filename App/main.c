@@ -17,8 +17,16 @@ static void system_clock_config(void);
 static void GPIO_init(void);
 static void led_task(void *argument);
 static void iot_task(void *argument);
-static void process_http_response(void);
+static void sample_display_temp(void* context);
+static void sample_telemetry_temp(void* context);
 static void log_device_info(void);
+static void log_sleep_residency(SleepStats* last, uint32_t period_ms);
+static void log_motion_stats(void);
+static void log_stack_headroom(void);
+static void process_motion(void);
+static bool read_filtered_temp(void);
+static int16_t round_to_int16(float value);
+static char* format_milli(int32_t milli, char* buffer, uint32_t size);
 
 
 /*
@@ -29,19 +37,41 @@ static void log_device_info(void);
 static osThreadId_t task_led;
 static const osThreadAttr_t led_task_attributes = {
     .name = "LEDTask",
-    .stack_size = 4096,
+    .stack_size = LED_TASK_STACK_SIZE_B,
     .priority = (osPriority_t)osPriorityNormal
 };
 
-// This is the FreeRTOS thread task that reads the sensor
-// and displays the temperature on the LED
+// This is the FreeRTOS thread task that posts readings
+// and talks to the server
 static osThreadId_t task_iot;
 static const osThreadAttr_t iot_task_attributes = {
     .name = "IOTTask",
-    .stack_size = 8192,
+    .stack_size = IOT_TASK_STACK_SIZE_B,
     .priority = (osPriority_t)osPriorityNormal
 };
 
+// This is the FreeRTOS thread task that reads the sensors
+// on schedule. It runs above the others to keep readings
+// on time
+static osThreadId_t task_sampler;
+static const osThreadAttr_t sampler_task_attributes = {
+    .name = "SamplerTask",
+    .stack_size = SAMPLER_TASK_STACK_SIZE_B,
+    .priority = (osPriority_t)osPriorityAboveNormal
+};
+
+// Readings passed from the sampler task to the IoT task for upload
+static osMessageQueueId_t sample_queue;
+static int8_t telemetry_schedule = -1;
+static volatile uint32_t samples_dropped = 0;
+
+// Filters for the sensors' readings. The sampler task owns the
+// temperature chain, the IoT task the acceleration chains
+static FilterChain temp_filter;
+static FilterChain accel_filters[FEATURES_AXIS_COUNT];
+static uint32_t temp_tick = 0;
+static bool is_temp_uploaded = false;
+
 // I2C-related values
 I2C_HandleTypeDef i2c;
 
@@ -52,24 +82,13 @@ I2C_HandleTypeDef i2c;
  *  doesn't render them immutable at runtime
  */
 volatile bool use_i2c = false;
-volatile bool received_request = false;
-volatile bool channel_was_closed = false;
 
-static volatile double temp = 0.0;
+static volatile int16_t temp_raw = 0;
+static volatile bool has_temp_reading = false;
 static volatile bool is_connected = false;
-static volatile bool interrupt_triggered = false;
 static volatile bool got_sensor_temp = false;
 static volatile bool got_sensor_accl = false;
 
-/**
- * These variables are defined in `http.c`
- */
-extern struct {
-    MvNotificationHandle notification;
-    MvNetworkHandle      network;
-    MvChannelHandle      channel;
-} http_handles;
-
 
 /**
  * @brief The application entry point.
@@ -85,6 +104,9 @@ int main(void) {
     // Get the Device ID and build number
     log_device_info();
     
+    // Start the cycle counter, for timings shorter than the tick
+    if (!cycles_init()) server_error("No DWT cycle counter: sub-ms timings will read 0");
+    
     // Start the network
     net_open_network();
 
@@ -117,8 +139,16 @@ int main(void) {
         got_sensor_accl = LIS3DH_init();
     }
     
+    // Filter readings before they're shown or uploaded
+    filter_chain_init(&temp_filter, TEMP_MEDIAN_SIZE, filter_lowpass_tenth, FILTER_LOWPASS_STAGES,
+                      FILTER_EMA_ALPHA(TEMP_EMA_SPAN), config_get()->temp_filters);
+    for (uint32_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) {
+        filter_chain_init(&accel_filters[i], ACCEL_MEDIAN_SIZE, filter_lowpass_tenth, FILTER_LOWPASS_STAGES,
+                          FILTER_EMA_ALPHA(ACCEL_EMA_SPAN), config_get()->accel_filters);
+    }
+    
     // Prep the MCP9808 temperature sensor (if present)
-    if (got_sensor_temp) temp = MCP9808_read_temp();
+    if (got_sensor_temp) read_filtered_temp();
 
     // Prep the LIS3DH accelerometer (if present)
     if (got_sensor_accl) {
@@ -129,17 +159,32 @@ int main(void) {
 
         // Configure the LIS3DH
         LIS3DH_set_mode(LIS3DH_MODE_NORMAL);
-        LIS3DH_set_data_rate(100);
-        LIS3DH_configure_click_irq(true, LIS3DH_SINGLE_CLICK, 1.1, 5, 10, 50);
+        LIS3DH_configure_click_irq(true, LIS3DH_SINGLE_CLICK, config_get()->click_threshold_mg, 5, 10, 50);
         LIS3DH_configure_irq_latching(true);
+        
+        // Stream samples through the FIFO, and summarize them
+        // as features rather than uploading them
+        motion_start(MOTION_SAMPLE_RATE_HZ);
+        features_set_window(config_get()->feature_window_ms, MOTION_SAMPLE_RATE_HZ);
+        spectrum_start(SPECTRUM_AXIS_Z, MOTION_SAMPLE_RATE_HZ);
+    }
+    
+    // Schedule temperature readings: frequent ones for the
+    // display, and ones at the configured rate for upload
+    if (got_sensor_temp) {
+        sampler_add_schedule("display", TEMP_DISPLAY_PERIOD_MS, sample_display_temp, NULL);
+        telemetry_schedule = sampler_add_schedule("telemetry", config_get()->sample_period_ms, sample_telemetry_temp, NULL);
     }
 
     // Init scheduler
     osKernelInitialize();
+    I2C_init_arbiter();
+    sample_queue = osMessageQueueNew(SAMPLE_QUEUE_SIZE_R, sizeof(TelemetrySample), NULL);
 
     // Create the thread(s)
     task_iot = osThreadNew(iot_task, NULL, &iot_task_attributes);
     task_led = osThreadNew(led_task, NULL, &led_task_attributes);
+    task_sampler = osThreadNew(sampler_task, NULL, &sampler_task_attributes);
 
     // Start the scheduler
     osKernelStart();
@@ -207,8 +252,9 @@ static void GPIO_init(void) {
     GPIO_InitStruct2.Pull  = GPIO_NOPULL;
     HAL_GPIO_Init(LIS3DH_INT_GPIO_BANK, &GPIO_InitStruct2);
 
-    // Set up the NVIC to process interrupts
-    HAL_NVIC_SetPriority(LIS3DH_INT_IRQ, 3, 0);
+    // Set up the NVIC to process interrupts. The handler notifies
+    // a task, so it can be no more urgent than the RTOS allows
+    HAL_NVIC_SetPriority(LIS3DH_INT_IRQ, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0);
     HAL_NVIC_EnableIRQ(LIS3DH_INT_IRQ);
 }
 
@@ -221,6 +267,7 @@ static void GPIO_init(void) {
 static void led_task(void *argument) {
     
     uint32_t last_tick = 0;
+    uint8_t brightness = CONFIG_MAX_BRIGHTNESS;
 
     // The task's main loop
     while (true) {
@@ -228,34 +275,31 @@ static void led_task(void *argument) {
         uint32_t tick = HAL_GetTick();
 
         // Periodically update the display and flash the USER LED
-        if (tick - last_tick > DEFAULT_TASK_PAUSE_MS) {
+        if (tick - last_tick >= DEFAULT_TASK_PAUSE_MS) {
             // Flip the USER LED
             HAL_GPIO_TogglePin(LED_GPIO_BANK, LED_GPIO_PIN);
             last_tick = tick;
         }
         
         // Check connection state
-        is_connected = false;
-        if (http_handles.network != 0) {
-            enum MvNetworkStatus net_state = MV_NETWORKSTATUS_DELIBERATELYOFFLINE;
-            enum MvStatus status = mvGetNetworkStatus(http_handles.network, &net_state);
-
-            if (status == MV_STATUS_OKAY) {
-                is_connected = (net_state == MV_NETWORKSTATUS_CONNECTED);
-            }
-        } else {
-            http_handles.network = net_get_handle();
-        }
+        is_connected = net_is_connected();
 
         // Display the temperature
         if (use_i2c) {
-            HT16K33_show_value((uint16_t)(temp * 100), true);
+            // Apply any brightness change from the server
+            if (config_get()->brightness != brightness) {
+                brightness = config_get()->brightness;
+                HT16K33_set_brightness(brightness);
+            }
+            
+            HT16K33_show_value((uint16_t)(MCP9808_raw_to_millicelsius(temp_raw) / 10), true);
             HT16K33_set_alpha('c', 3, !is_connected);
             HT16K33_draw();
         }
 
-        // End of cycle delay
-        osDelay(10);
+        // Sleep until the next LED flash, or until a new reading is posted
+        uint32_t elapsed = HAL_GetTick() - last_tick;
+        osThreadFlagsWait(LED_FLAG_REFRESH, osFlagsWaitAny, elapsed < DEFAULT_TASK_PAUSE_MS ? DEFAULT_TASK_PAUSE_MS - elapsed : 0);
     }
 }
 
@@ -268,128 +312,332 @@ static void led_task(void *argument) {
 static void iot_task(void *argument) {
     
     // Time trackers
-    uint32_t read_tick = 0;
-    uint32_t kill_time = 0;
-    bool do_close_channel = false;
-    enum MvStatus result = MV_STATUS_OKAY;
+    uint32_t stats_tick = 0;
+    SleepStats last_sleep = { 0 };
+    uint32_t click_threshold = config_get()->click_threshold_mg;
+    uint32_t sample_period = config_get()->sample_period_ms;
+    uint32_t feature_window = config_get()->feature_window_ms;
+    uint8_t temp_filters = config_get()->temp_filters;
+    uint8_t accel_filter_stages = config_get()->accel_filters;
     
     // Set up channel notifications
     http_notification_center_setup();
 
     // Run the thread's main loop
+    uint32_t flags = 0;
     while (true) {
         uint32_t tick = HAL_GetTick();
+        uint32_t wait = IOT_TASK_MAX_WAIT_MS;
 
         if (got_sensor_temp) {
-            // Get the temperature
-            temp = MCP9808_read_temp();
-            
-            if (tick - read_tick > SENSOR_READ_PERIOD_MS) {
-                // Read the sensor every x seconds
-                read_tick = tick;
-                server_log("Temperature: %.02f°C", temp);
-                
-                // No channel open? Try and send the temperature
-                if (http_handles.channel == 0 && http_open_channel()) {
-                    result = http_send_request(temp);
-                    if (result > 0) do_close_channel = true;
-                    kill_time = tick;
-                } else {
-                    server_error("Channel handle not zero");
-                    do_close_channel = true;
-                }
+            // Add readings taken by the sampler task to the current batch
+            TelemetrySample sample;
+            while (osMessageQueueGet(sample_queue, &sample, NULL, 0) == osOK) {
+                char temp[FORMAT_MILLI_SIZE_B];
+                server_log("Temperature: %s°C", format_milli(MCP9808_raw_to_millicelsius(sample.temp), temp, sizeof(temp)));
+                telemetry_add_sample(sample.temp, sample.tick);
             }
             
-            // Process a request's response if indicated by the ISR
-            if (received_request) process_http_response();
+            // Queue the batch for upload if it's full or old enough
+            telemetry_service();
             
-            // FROM 2.1.6
-            // Was the channel closed unexpectedly?
-            // `channel_was_closed` set in IRS
-            if (channel_was_closed) do_close_channel = true;
+            // Apply any sampling period change from the server
+            if (config_get()->sample_period_ms != sample_period) {
+                sample_period = config_get()->sample_period_ms;
+                sampler_set_period(telemetry_schedule, sample_period);
+                server_log("Sample period set to %lu ms", sample_period);
+            }
             
-            // Use 'kill_time' to force-close an open HTTP channel
-            // if it's been left open too long
-            if (kill_time > 0 && tick - kill_time > CHANNEL_KILL_PERIOD_MS) {
-                do_close_channel = true;
-                server_error("HTTP request timed out");
+            // The sampler task applies temperature filter changes,
+            // as it owns the chain, but can't log them
+            if (config_get()->temp_filters != temp_filters) {
+                temp_filters = config_get()->temp_filters;
+                server_log("Temperature filters set to 0x%02X", temp_filters);
             }
+        }
+        
+        // Issue queued requests, process responses and close
+        // the HTTP channel if it has been idle for long enough
+        uint32_t next = http_service();
+        if (next < wait) wait = next;
+        
+        // Report how much of the last period the CPU spent asleep,
+        // how closely the sampler kept to its schedules, how often
+        // the I2C devices had to wait for the bus, how the telemetry
+        // store is draining, and how close each task has come to
+        // the end of its stack
+        if (tick - stats_tick >= RUNTIME_STATS_PERIOD_MS) {
+            log_sleep_residency(&last_sleep, tick - stats_tick);
+            sampler_log_stats();
+            I2C_log_stats();
+            telemetry_log_stats();
+            log_motion_stats();
+            log_stack_headroom();
             
-            // Close the channel if asked to do so or
-            // a request yielded a response
-            if (do_close_channel || received_request) {
-                do_close_channel = false;
-                received_request = false;
-                kill_time = 0;
-                http_close_channel();
+            // Put back any accelerometer settings the sensor has lost
+            if (got_sensor_accl) {
+                uint8_t lost = LIS3DH_verify_registers(true);
+                if (lost > 0) server_error("LIS3DH lost %u register settings -- restored", lost);
             }
+            
+            if (samples_dropped > 0) server_error("Sample queue full -- %lu readings dropped", samples_dropped);
+            stats_tick = tick;
         }
         
-        // Was an interrupt triggered? If so, log the fact
-        if (interrupt_triggered) {
-            interrupt_triggered = false;
-            server_log("Interrupt signal on GPIO PF3");
-
-            if (use_i2c) {
-                InterruptTable table;
-                LIS3DH_get_interrupt_table(&table);
-                if (table.single_click) {
-                    server_log("Device tapped once");
-                    http_send_warning();
+        // Apply any tap threshold change from the server
+        if (got_sensor_accl && config_get()->click_threshold_mg != click_threshold) {
+            click_threshold = config_get()->click_threshold_mg;
+            LIS3DH_configure_click_irq(true, LIS3DH_SINGLE_CLICK, click_threshold, 5, 10, 50);
+            server_log("Tap threshold set to %lu mG", click_threshold);
+        }
+        
+        // Apply any feature window change from the server
+        if (got_sensor_accl && config_get()->feature_window_ms != feature_window) {
+            feature_window = config_get()->feature_window_ms;
+            features_set_window(feature_window, MOTION_SAMPLE_RATE_HZ);
+            server_log("Feature window set to %lu ms", feature_window);
+        }
+        
+        // Apply any acceleration filter change from the server
+        if (got_sensor_accl && config_get()->accel_filters != accel_filter_stages) {
+            accel_filter_stages = config_get()->accel_filters;
+            for (uint32_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) filter_chain_set_stages(&accel_filters[i], accel_filter_stages);
+            server_log("Acceleration filters set to 0x%02X", accel_filter_stages);
+        }
+        
+        // Was an interrupt triggered? INT1 signals both taps and
+        // the FIFO reaching its watermark, so check for each
+        if ((flags & IOT_FLAG_SENSOR_IRQ) && got_sensor_accl) {
+            // Drain the FIFO into the sample ring, then pass the
+            // samples on for analysis
+            motion_service();
+            process_motion();
+            
+            InterruptTable table;
+            LIS3DH_get_interrupt_table(&table);
+            if (table.single_click) {
+                server_log("Device tapped once");
+                http_send_warning();
+                
+                // Reading the output registers would pop the FIFO,
+                // so report the newest sample drained from it
+                AccelRaw accel;
+                if (motion_latest(&accel)) {
+                    char x[FORMAT_MILLI_SIZE_B], y[FORMAT_MILLI_SIZE_B], z[FORMAT_MILLI_SIZE_B];
+                    server_log("Acceleration X:%sG, Y:%sG, Z:%sG",
+                               format_milli(LIS3DH_raw_to_mg(accel.x), x, sizeof(x)),
+                               format_milli(LIS3DH_raw_to_mg(accel.y), y, sizeof(y)),
+                               format_milli(LIS3DH_raw_to_mg(accel.z), z, sizeof(z)));
                 }
-
-                AccelResult accel;
-                LIS3DH_get_accel(&accel);
-                server_log("Acceleration X:%0.2fG, Y:%0.2fG, Z:%0.2fG", accel.x, accel.y, accel.z);
+            }
+            
+            // The interrupt is edge-triggered, so if INT1 is still high,
+            // eg. the FIFO refilled as we drained it, we won't get
+            // another: come straight back
+            if (HAL_GPIO_ReadPin(LIS3DH_INT_GPIO_BANK, LIS3DH_INT_GPIO_PIN) == GPIO_PIN_SET) {
+                osThreadFlagsSet(task_iot, IOT_FLAG_SENSOR_IRQ);
             }
         }
 
-        // End of cycle delay
-        osDelay(10);
+        // Sleep until the next deadline, or until an ISR notifies us of a
+        // channel event or a sensor interrupt, or the sampler posts a
+        // reading. The wait is capped, so we still notice changes nothing
+        // notifies us of, such as the network coming up
+        flags = osThreadFlagsWait(IOT_FLAG_HTTP_EVENT | IOT_FLAG_SENSOR_IRQ | IOT_FLAG_SAMPLE, osFlagsWaitAny, wait);
+        if (flags & osFlagsError) flags = 0;
     }
 }
 
 
 /**
- * @brief Process HTTP response data.
+ * @brief Sampler callback: read the temperature for the display.
+ *
+ * Keeps the last good reading if this fails, and only wakes
+ * the display task if the value has changed.
+ *
+ * @param context: Not used.
  */
-static void process_http_response(void) {
-    
-    // We have received data via the active HTTP channel so establish
-    // an `MvHttpResponseData` record to hold response metadata
-    struct MvHttpResponseData resp_data;
-    enum MvStatus status = mvReadHttpResponseData(http_handles.channel, &resp_data);
-    if (status == MV_STATUS_OKAY) {
-        // Check we successfully issued the request (`result` is OK) and
-        // the request was successful (status code 200)
-        if (resp_data.result == MV_HTTPRESULT_OK) {
-            if (resp_data.status_code == 200) {
-                server_log("HTTP response header count: %lu", resp_data.num_headers);
-                server_log("HTTP response body length: %lu", resp_data.body_length);
-                
-                // Set up a buffer that we'll get Microvisor to write
-                // the response body into
-                uint8_t buffer[resp_data.body_length + 1];
-                memset((void *)buffer, 0x00, resp_data.body_length + 1);
-                status = mvReadHttpResponseBody(http_handles.channel, 0, buffer, resp_data.body_length);
-                if (status == MV_STATUS_OKAY) {
-                    // Retrieved the body data successfully so log it
-                    server_log("Message body:\n%s", buffer);
-                } else {
-                    server_error("HTTP response body read status %i", status);
-                }
-            } else {
-                server_error("HTTP status code: %lu", resp_data.status_code);
-            }
-        } else {
-            server_error("Request failed. Status: %i", resp_data.result);
-        }
+static void sample_display_temp(void* context) {
+    
+    int16_t last = temp_raw;
+    if (read_filtered_temp() && temp_raw != last) osThreadFlagsSet(task_led, LED_FLAG_REFRESH);
+}
+
+
+/**
+ * @brief Sampler callback: read the temperature for upload.
+ *
+ * The reading is passed to the IoT task, which owns the telemetry
+ * store. If the IoT task has fallen so far behind that the queue
+ * is full, the reading is dropped and counted: we don't log here,
+ * as logging isn't safe outside the IoT task.
+ *
+ * @param context: Not used.
+ */
+static void sample_telemetry_temp(void* context) {
+    
+    // Upload the display stream's latest filtered value, so the filters
+    // see one evenly spaced stream. Read afresh only if that's stale, or
+    // has been uploaded already, as it will have been if the sample
+    // period is shorter than the display's
+    bool is_stale = !has_temp_reading || HAL_GetTick() - temp_tick > 2 * TEMP_DISPLAY_PERIOD_MS;
+    if ((is_stale || is_temp_uploaded) && !read_filtered_temp()) return;
+    
+    TelemetrySample sample = { .tick = temp_tick, .temp = temp_raw };
+    is_temp_uploaded = true;
+    if (osMessageQueuePut(sample_queue, &sample, 0, 0) == osOK) {
+        osThreadFlagsSet(task_iot, IOT_FLAG_SAMPLE);
     } else {
-        server_error("Response data read failed. Status: %i", status);
+        samples_dropped++;
     }
 }
 
 
+/**
+ * @brief Read the temperature and pass it through the filter chain.
+ *
+ * The filtered value, still in the sensor's 1/16°C steps, becomes the
+ * one displayed and uploaded. Any filter change from the server is
+ * applied first. Only the sampler task calls this once it's running.
+ *
+ * @returns `true` if the sensor was read, otherwise `false`.
+ */
+static bool read_filtered_temp(void) {
+    
+    int16_t reading = 0;
+    if (MCP9808_read_raw(&reading) != HAL_OK) return false;
+    
+    if (config_get()->temp_filters != temp_filter.stages) filter_chain_set_stages(&temp_filter, config_get()->temp_filters);
+    temp_raw = round_to_int16(filter_chain_apply(&temp_filter, (float)reading));
+    temp_tick = HAL_GetTick();
+    has_temp_reading = true;
+    is_temp_uploaded = false;
+    return true;
+}
+
+
+/**
+ * @brief Round a filtered value to the nearest sensor count.
+ *
+ * @param value: The value.
+ *
+ * @returns The count, clamped to the range of an int16_t.
+ */
+static int16_t round_to_int16(float value) {
+    
+    if (value >= (float)INT16_MAX) return INT16_MAX;
+    if (value <= (float)INT16_MIN) return INT16_MIN;
+    return (int16_t)lroundf(value);
+}
+
+
+/**
+ * @brief Log the share of a period the CPU spent in tickless sleep.
+ *
+ * @param last:      The counters at the start of the period. Updated to the current values.
+ * @param period_ms: The length of the period.
+ */
+static void log_sleep_residency(SleepStats* last, uint32_t period_ms) {
+    
+    SleepStats now;
+    timebase_get_sleep_stats(&now);
+    
+    uint32_t slept_ms = (uint32_t)((now.slept_us - last->slept_us) / 1000);
+    uint32_t sleeps = now.sleeps - last->sleeps;
+    *last = now;
+    
+    if (period_ms == 0) return;
+    server_log("Sleep: %lu.%lu%% of %lu s, %lu sleeps (mean %lu ms)",
+               (uint32_t)((uint64_t)slept_ms * 100 / period_ms),
+               (uint32_t)((uint64_t)slept_ms * 1000 / period_ms % 10),
+               period_ms / 1000,
+               sleeps,
+               sleeps > 0 ? slept_ms / sleeps : 0);
+}
+
+
+/**
+ * @brief Filter the samples waiting in the motion ring, then pass them to
+ *        the feature window and the spectrum analyzer, which each take
+ *        every sample.
+ */
+static void process_motion(void) {
+    
+    AccelRaw chunk[MOTION_READ_CHUNK_R];
+    uint32_t count = 0;
+    while ((count = motion_read(chunk, MOTION_READ_CHUNK_R)) > 0) {
+        for (uint32_t i = 0 ; i < count ; ++i) {
+            chunk[i].x = round_to_int16(filter_chain_apply(&accel_filters[0], (float)chunk[i].x));
+            chunk[i].y = round_to_int16(filter_chain_apply(&accel_filters[1], (float)chunk[i].y));
+            chunk[i].z = round_to_int16(filter_chain_apply(&accel_filters[2], (float)chunk[i].z));
+        }
+        
+        features_add_samples(chunk, count);
+        spectrum_add_samples(chunk, count);
+    }
+}
+
+
+/**
+ * @brief Log the acceleration stream's counters.
+ */
+static void log_motion_stats(void) {
+    
+    if (!got_sensor_accl) return;
+    
+    MotionStats stats;
+    motion_get_stats(&stats);
+    server_log("Motion: %lu samples in %lu drains (max %lu), %lu FIFO overruns, %lu ring overruns",
+               stats.samples, stats.drains, stats.max_drain, stats.fifo_overruns, stats.ring_overruns);
+    
+    FeatureStats feature_stats;
+    features_get_stats(&feature_stats);
+    server_log("Motion features: %lu windows, %lu queued, %lu dropped",
+               feature_stats.windows, feature_stats.queued, feature_stats.dropped);
+    
+    // Report the latest frame's strongest frequencies
+    SpectrumResult spectrum;
+    if (spectrum_latest(&spectrum)) {
+        for (uint8_t i = 0 ; i < spectrum.count ; ++i) {
+            server_log("Spectrum peak %u: %lu.%02lu Hz, %lu mG", i + 1,
+                       spectrum.peaks[i].frequency / 100, spectrum.peaks[i].frequency % 100, spectrum.peaks[i].amplitude_mg);
+        }
+    }
+}
+
+
+/**
+ * @brief Log the least free stack space each task has had, so
+ *        the stack sizes in `main.h` can be checked against use.
+ */
+static void log_stack_headroom(void) {
+    
+    server_log("Stack headroom: LED %lu of %u, IoT %lu of %u, sampler %lu of %u bytes",
+               osThreadGetStackSpace(task_led), LED_TASK_STACK_SIZE_B,
+               osThreadGetStackSpace(task_iot), IOT_TASK_STACK_SIZE_B,
+               osThreadGetStackSpace(task_sampler), SAMPLER_TASK_STACK_SIZE_B);
+}
+
+
+/**
+ * @brief Write a value held in thousandths as decimal text with two places,
+ *        eg. -1234 as "-1.23", without any floating-point work.
+ *
+ * @param milli:  The value, multiplied by 1000.
+ * @param buffer: Where to write the text.
+ * @param size:   The size of the buffer.
+ *
+ * @returns The buffer.
+ */
+static char* format_milli(int32_t milli, char* buffer, uint32_t size) {
+    
+    // Truncate towards zero, so both signs round the same way
+    uint32_t centi = (milli < 0 ? 0 - (uint32_t)milli : (uint32_t)milli) / 10;
+    snprintf(buffer, size, "%s%lu.%02lu", milli <= -10 ? "-" : "", centi / 100, centi % 100);
+    return buffer;
+}
+
+
 /**
  * @brief Show basic device info.
  */
@@ -430,7 +678,7 @@ void report_and_assert(uint16_t err_code) {
  */
 void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin) {
     
-    interrupt_triggered = true;
+    if (task_iot != NULL) osThreadFlagsSet(task_iot, IOT_FLAG_SENSOR_IRQ);
 }
 
 
@@ -441,7 +689,7 @@ void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin) {
  */
 void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin) {
     
-    interrupt_triggered = true;
+    if (task_iot != NULL) osThreadFlagsSet(task_iot, IOT_FLAG_SENSOR_IRQ);
 }
 
 
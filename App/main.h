@@ -22,6 +22,7 @@
 #include <errno.h>
 #include <time.h>
 #include <assert.h>
+#include <math.h>
 
 // Microvisor includes
 #include "stm32u5xx_hal.h"
@@ -35,7 +36,20 @@
 #include "i2c.h"
 #include "mcp9808.h"
 #include "lis3dh.h"
+#include "filter.h"
+#include "telemetry.h"
+#include "motion_features.h"
+#include "json.h"
+#include "config.h"
 #include "http.h"
+#include "cbor.h"
+#include "pack.h"
+#include "latency.h"
+#include "cycles.h"
+#include "timebase.h"
+#include "sampler.h"
+#include "motion.h"
+#include "spectrum.h"
 #include "network.h"
 
 
@@ -52,12 +66,42 @@
 
 #define     DEBUG_TASK_PAUSE_MS         1000
 #define     DEFAULT_TASK_PAUSE_MS       500
+#define     IOT_TASK_MAX_WAIT_MS        1000
+
+// Task notification flags
+#define     IOT_FLAG_HTTP_EVENT         HTTP_EVENT_FLAG
+#define     IOT_FLAG_SENSOR_IRQ         0x0002
+#define     IOT_FLAG_SAMPLE             0x0004
+#define     LED_FLAG_REFRESH            0x0001
 
 #define     DEBOUNCE_PERIOD_MS          20
 #define     SENSOR_READ_PERIOD_MS       60000
+#define     TEMP_DISPLAY_PERIOD_MS      2000
 #define     CHANNEL_KILL_PERIOD_MS      15000
+#define     HTTP_CHANNEL_IDLE_MS        90000
+#define     RUNTIME_STATS_PERIOD_MS     300000
+
+// Task stacks. A task that has used the FPU is switched out with an extended
+// frame: s0-s15, FPSCR and a pad word stacked by the hardware, s16-s31 by the port
+#if ENABLE_HARDWARE_FPU == 1
+#define     TASK_FPU_CONTEXT_SIZE_B     136
+#else
+#define     TASK_FPU_CONTEXT_SIZE_B     0
+#endif
+#define     LED_TASK_STACK_SIZE_B       (4096 + TASK_FPU_CONTEXT_SIZE_B)
+#define     IOT_TASK_STACK_SIZE_B       (8192 + TASK_FPU_CONTEXT_SIZE_B)
+#define     SAMPLER_TASK_STACK_SIZE_B   (2048 + TASK_FPU_CONTEXT_SIZE_B)
 
 #define     HTTP_NT_BUFFER_SIZE_R       8             // NOTE Size in records, not bytes
+#define     SAMPLE_QUEUE_SIZE_R         4
+#define     FORMAT_MILLI_SIZE_B         16            // Fits "-2147483.64"
+
+// Reading filters. Spans are in samples of each stream: temperature
+// every TEMP_DISPLAY_PERIOD_MS, acceleration at MOTION_SAMPLE_RATE_HZ
+#define     TEMP_MEDIAN_SIZE            3
+#define     TEMP_EMA_SPAN               8
+#define     ACCEL_MEDIAN_SIZE           3
+#define     ACCEL_EMA_SPAN              4
 
 
 /*
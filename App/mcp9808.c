@@ -9,12 +9,6 @@
 #include "main.h"
 
 
-/*
- * GLOBALS
- */
-extern I2C_HandleTypeDef i2c;
-
-
 /**
  *  @brief  Check the device is connected and operational.
  *
@@ -28,14 +22,10 @@ bool MCP9808_init(void) {
     uint8_t did_data[2] = {0};
 
     // Read bytes from the sensor: MID...
-    uint8_t cmd = MCP9808_REG_MANUF_ID;
-    HAL_I2C_Master_Transmit(&i2c, MCP9808_ADDR << 1, &cmd,      1, 100);
-    HAL_I2C_Master_Receive(&i2c,  MCP9808_ADDR << 1, mid_data, 2, 100);
+    I2C_read_regs(MCP9808_ADDR, MCP9808_REG_MANUF_ID, mid_data, 2, 100);
 
     // ...DID
-    cmd = MCP9808_REG_DEVICE_ID;
-    HAL_I2C_Master_Transmit(&i2c, MCP9808_ADDR << 1, &cmd,      1, 100);
-    HAL_I2C_Master_Receive(&i2c,  MCP9808_ADDR << 1, did_data, 2, 100);
+    I2C_read_regs(MCP9808_ADDR, MCP9808_REG_DEVICE_ID, did_data, 2, 100);
 
     // Bytes to integers
     const uint16_t mid_value = (mid_data[0] << 8) | mid_data[1];
@@ -48,24 +38,62 @@ bool MCP9808_init(void) {
 
 
 /**
- *  @brief  Check the device is connected and operational.
+ *  @brief  Read the temperature in thousandths of a degree Celsius.
+ *
+ *  @param millicelsius: Set to the temperature, if there is a reading.
+ *
+ *  @returns The HAL status of the read.
+ */
+HAL_StatusTypeDef MCP9808_read_temp(int32_t* millicelsius) {
+    
+    int16_t temp_raw = 0;
+    HAL_StatusTypeDef result = MCP9808_read_raw(&temp_raw);
+    if (result == HAL_OK) *millicelsius = MCP9808_raw_to_millicelsius(temp_raw);
+    return result;
+}
+
+
+/**
+ *  @brief  Read the temperature as the sensor reports it.
  *
- *  @returns `true` if the sensor is correct, otherwise `false`.
+ *  The ambient temperature register holds a 13-bit two's complement
+ *  value in units of 1/16 degree Celsius. It is returned sign extended,
+ *  so it can be stored and transmitted without any loss of precision.
+ *
+ *  @param temp_raw: Set to the reading, if there is one.
+ *
+ *  @returns The HAL status of the read.
  */
-double MCP9808_read_temp(void) {
+HAL_StatusTypeDef MCP9808_read_raw(int16_t* temp_raw) {
     
-    // Read sensor and return its value in degrees celsius.
     uint8_t temp_data[2] = { 0x06, 0x30 };
-    uint8_t cmd = MCP9808_REG_AMBIENT_TEMP;
-    HAL_I2C_Master_Transmit(&i2c, MCP9808_ADDR << 1, &cmd, 1, 200);
-    HAL_StatusTypeDef result = HAL_I2C_Master_Receive(&i2c, MCP9808_ADDR << 1, temp_data, 2, 500);
+    HAL_StatusTypeDef result = I2C_read_regs(MCP9808_ADDR, MCP9808_REG_AMBIENT_TEMP, temp_data, 2, 500);
+    
+    // A failed or cancelled read may have written some of the buffer,
+    // so trust its contents only if the read succeeded
+    if (result != HAL_OK) return result;
     
-    // Check for a read error -- if there is one, return its code
-    const uint32_t temp_raw = (temp_data[0] << 8) | temp_data[1];
-    if (temp_raw == 0x630) return (double)result;
+    // Check for a read that succeeded but returned nothing
+    const uint32_t temp_bits = (temp_data[0] << 8) | temp_data[1];
+    if (temp_bits == 0x630) return HAL_ERROR;
+    
+    // Drop the alert flags (bits 13-15) and sign extend from bit 12
+    *temp_raw = (int16_t)((temp_bits & 0x1FFF) << 3) >> 3;
+    return HAL_OK;
+}
+
+
+/**
+ *  @brief  Convert a raw reading to thousandths of a degree Celsius.
+ *
+ *  A count is 62.5m°C, so the result is exact to within half a
+ *  millidegree, and is calculated without any floating-point work.
+ *
+ *  @param temp_raw: A reading from `MCP9808_read_raw()`.
+ *
+ *  @returns The temperature in m°C.
+ */
+int32_t MCP9808_raw_to_millicelsius(int16_t temp_raw) {
     
-    // Scale and convert to signed value.
-    double temp_cel = (temp_raw & 0x0FFF) / 16.0;
-    if (temp_raw & 0x1000) temp_cel -= 256.0;
-    return temp_cel;
+    return ((int32_t)temp_raw * MCP9808_MILLICELSIUS_NUM) / MCP9808_MILLICELSIUS_DEN;
 }
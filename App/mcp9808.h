@@ -25,6 +25,10 @@
 #define MCP9808_REG_MANUF_ID        0x06
 #define MCP9808_REG_DEVICE_ID       0x07
 
+// Scale from 1/16°C counts to m°C: 1000/16, reduced
+#define MCP9808_MILLICELSIUS_NUM    125
+#define MCP9808_MILLICELSIUS_DEN    2
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,8 +38,10 @@ extern "C" {
 /*
  *  PROTOTYPES
  */
-bool        MCP9808_init(void) ;
-double      MCP9808_read_temp(void);
+bool                MCP9808_init(void) ;
+HAL_StatusTypeDef   MCP9808_read_temp(int32_t* millicelsius);
+HAL_StatusTypeDef   MCP9808_read_raw(int16_t* temp_raw);
+int32_t             MCP9808_raw_to_millicelsius(int16_t temp_raw);
 
 
 #ifdef __cplusplus
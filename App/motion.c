@@ -0,0 +1,147 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * GLOBALS
+ */
+// Ring of acceleration samples, oldest first. The indexes run
+// freely and are masked on use. Both ends are used by the same
+// task, so there's no locking
+static AccelRaw ring[MOTION_RING_SIZE_R];
+static uint32_t ring_head = 0;
+static uint32_t ring_tail = 0;
+
+static bool is_streaming = false;
+static MotionStats stats = { 0 };
+
+
+/**
+ * @brief Stream acceleration samples through the LIS3DH's FIFO.
+ *
+ * The sensor samples into its FIFO in stream mode and raises INT1
+ * when the FIFO passes MOTION_FIFO_WATERMARK, so the host wakes once
+ * per FIFO fill rather than once per sample. Call `motion_service()`
+ * when the interrupt fires.
+ *
+ * @param rate_hz: The sample rate. See `LIS3DH_set_data_rate()` for the rates supported.
+ */
+void motion_start(uint32_t rate_hz) {
+    
+    ring_head = 0;
+    ring_tail = 0;
+    
+    LIS3DH_set_data_rate(rate_hz);
+    LIS3DH_set_fifo_watermark(MOTION_FIFO_WATERMARK);
+    LIS3DH_configure_fifo(true, LIS3DH_FIFO_STREAM_MODE);
+    LIS3DH_configure_watermark_irq(true);
+    is_streaming = true;
+}
+
+
+/**
+ * @brief Stop streaming. Samples already in the ring remain readable.
+ */
+void motion_stop(void) {
+    
+    LIS3DH_configure_watermark_irq(false);
+    LIS3DH_configure_fifo(false, LIS3DH_FIFO_BYPASS_MODE);
+    is_streaming = false;
+}
+
+
+/**
+ * @brief Move every sample in the sensor's FIFO into the ring.
+ *
+ * If the ring is full, the oldest samples are overwritten.
+ *
+ * @returns The number of samples moved.
+ */
+uint32_t motion_service(void) {
+    
+    if (!is_streaming) return 0;
+    
+    AccelRaw drained[LIS3DH_FIFO_SIZE];
+    bool overrun = false;
+    uint32_t count = LIS3DH_read_fifo(drained, LIS3DH_FIFO_SIZE, &overrun);
+    if (overrun) stats.fifo_overruns++;
+    if (count == 0) return 0;
+    
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        if (ring_head - ring_tail == MOTION_RING_SIZE_R) {
+            ring_tail++;
+            stats.ring_overruns++;
+        }
+        
+        ring[ring_head++ & (MOTION_RING_SIZE_R - 1)] = drained[i];
+    }
+    
+    stats.drains++;
+    stats.samples += count;
+    if (count > stats.max_drain) stats.max_drain = count;
+    return count;
+}
+
+
+/**
+ * @brief Get the number of samples waiting in the ring.
+ *
+ * @returns The number of samples.
+ */
+uint32_t motion_available(void) {
+    
+    return ring_head - ring_tail;
+}
+
+
+/**
+ * @brief Take the oldest samples from the ring.
+ *
+ * @param samples:     The buffer to copy into.
+ * @param max_samples: The buffer's size, in samples.
+ *
+ * @returns The number of samples copied.
+ */
+uint32_t motion_read(AccelRaw* samples, uint32_t max_samples) {
+    
+    uint32_t count = 0;
+    while (count < max_samples && ring_tail != ring_head) {
+        samples[count++] = ring[ring_tail++ & (MOTION_RING_SIZE_R - 1)];
+    }
+    
+    return count;
+}
+
+
+/**
+ * @brief Get the newest sample, without taking it from the ring.
+ *
+ * @param sample: Set to the newest sample, if there is one.
+ *
+ * @returns `true` if there was a sample, otherwise `false`.
+ */
+bool motion_latest(AccelRaw* sample) {
+    
+    if (ring_head == 0) return false;
+    *sample = ring[(ring_head - 1) & (MOTION_RING_SIZE_R - 1)];
+    return true;
+}
+
+
+/**
+ * @brief Get the stream's counters.
+ *
+ * @param data: Pointer to a MotionStats structure.
+ *              (see motion.h)
+ */
+void motion_get_stats(MotionStats* data) {
+    
+    *data = stats;
+}
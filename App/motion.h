@@ -0,0 +1,60 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _MOTION_H_
+#define _MOTION_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     MOTION_SAMPLE_RATE_HZ       100
+#define     MOTION_RING_SIZE_R          256           // NOTE Size in records, not bytes. Must be a power of two
+#define     MOTION_READ_CHUNK_R         32
+
+// Raise the watermark interrupt when the FIFO holds more than this
+// many samples. The slots above it are the time the task has to drain
+// the FIFO before it overruns: 8 samples is 80 ms at 100 Hz
+#define     MOTION_FIFO_WATERMARK       23
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    drains;
+    uint32_t    samples;
+    uint32_t    max_drain;
+    uint32_t    fifo_overruns;
+    uint32_t    ring_overruns;
+} MotionStats;          // Record for acceleration stream counters
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        motion_start(uint32_t rate_hz);
+void        motion_stop(void);
+uint32_t    motion_service(void);
+uint32_t    motion_available(void);
+uint32_t    motion_read(AccelRaw* samples, uint32_t max_samples);
+bool        motion_latest(AccelRaw* sample);
+void        motion_get_stats(MotionStats* data);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _MOTION_H_
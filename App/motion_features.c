@@ -0,0 +1,221 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void features_add_sample(const AccelRaw* sample);
+static void features_finish_window(void);
+static void features_restart_window(void);
+
+
+/*
+ * GLOBALS
+ */
+// Running totals for the window in progress. Each axis's values are
+// taken from a reference level -- the previous window's mean -- which
+// keeps the totals small, so the variance doesn't lose precision to
+// the 1G offset of gravity, and gives zero crossings a level to cross
+static AxisAccumulator accumulators[FEATURES_AXIS_COUNT];
+static uint32_t window_samples = 0;
+static uint32_t window_count = 0;
+static uint32_t sample_rate_hz = MOTION_SAMPLE_RATE_HZ;
+static bool has_reference = false;
+
+static MotionFeatures latest;
+static bool has_latest = false;
+static FeatureStats stats = { 0 };
+
+
+/**
+ * @brief Set the length of the feature window, and start a new window.
+ *
+ * @param window_ms: The window length, clamped to FEATURES_MIN_WINDOW_MS
+ *                   to FEATURES_MAX_WINDOW_MS.
+ * @param rate_hz:   The rate the motion stream is sampled at.
+ */
+void features_set_window(uint32_t window_ms, uint32_t rate_hz) {
+    
+    if (window_ms < FEATURES_MIN_WINDOW_MS) window_ms = FEATURES_MIN_WINDOW_MS;
+    if (window_ms > FEATURES_MAX_WINDOW_MS) window_ms = FEATURES_MAX_WINDOW_MS;
+    
+    sample_rate_hz = rate_hz;
+    window_samples = (uint32_t)((uint64_t)window_ms * rate_hz / 1000);
+    if (window_samples == 0) window_samples = 1;
+    features_restart_window();
+}
+
+
+/**
+ * @brief Take samples into the current window, and queue the features
+ *        of each window that completes.
+ *
+ * Samples are processed as they arrive, in a single pass, so the raw
+ * samples needn't be kept.
+ *
+ * @param samples: The samples, oldest first.
+ * @param count:   The number of samples.
+ *
+ * @returns The number of windows completed.
+ */
+uint32_t features_add_samples(const AccelRaw* samples, uint32_t count) {
+    
+    if (window_samples == 0) return 0;
+    
+    uint32_t windows = 0;
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        features_add_sample(&samples[i]);
+        if (window_count == window_samples) {
+            features_finish_window();
+            windows++;
+        }
+    }
+    
+    return windows;
+}
+
+
+/**
+ * @brief Get the features of the most recently completed window.
+ *
+ * @param features: Set to the features, if there are any.
+ *
+ * @returns `true` if a window has completed, otherwise `false`.
+ */
+bool features_latest(MotionFeatures* features) {
+    
+    if (!has_latest) return false;
+    *features = latest;
+    return true;
+}
+
+
+/**
+ * @brief Get the feature extraction counters.
+ *
+ * @param data: Pointer to a FeatureStats structure.
+ *              (see motion_features.h)
+ */
+void features_get_stats(FeatureStats* data) {
+    
+    *data = stats;
+}
+
+
+/**
+ * @brief Add a sample to the current window's running totals.
+ *
+ * @param sample: The sample.
+ */
+static void features_add_sample(const AccelRaw* sample) {
+    
+    const int32_t values[FEATURES_AXIS_COUNT] = {
+        LIS3DH_raw_to_mg(sample->x),
+        LIS3DH_raw_to_mg(sample->y),
+        LIS3DH_raw_to_mg(sample->z)
+    };
+    
+    // With no window behind us, the first sample is the reference, so
+    // the first window's crossing rate understates a signal that
+    // starts far from its mean
+    if (!has_reference) {
+        for (uint8_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) {
+            accumulators[i].reference = values[i];
+            accumulators[i].is_above = false;
+        }
+        
+        has_reference = true;
+    }
+    
+    for (uint8_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) {
+        AxisAccumulator* acc = &accumulators[i];
+        int32_t value = values[i] - acc->reference;
+        
+        acc->sum += value;
+        acc->sum_squares += (uint64_t)((int64_t)value * value);
+        if (window_count == 0 || value < acc->min) acc->min = value;
+        if (window_count == 0 || value > acc->max) acc->max = value;
+        
+        // Count a crossing each time the signal passes through the band
+        if (acc->is_above && value < -FEATURES_CROSSING_BAND_MG) {
+            acc->is_above = false;
+            acc->crossings++;
+        } else if (!acc->is_above && value > FEATURES_CROSSING_BAND_MG) {
+            acc->is_above = true;
+            acc->crossings++;
+        }
+    }
+    
+    window_count++;
+}
+
+
+/**
+ * @brief Calculate the features of the completed window, queue them
+ *        for upload, and start the next window.
+ */
+static void features_finish_window(void) {
+    
+    MotionFeatures features;
+    features.tick = HAL_GetTick();
+    features.samples = window_count;
+    
+    const float count = (float)window_count;
+    for (uint8_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) {
+        AxisAccumulator* acc = &accumulators[i];
+        AxisFeatures* axis = &features.axes[i];
+        
+        // Mean and variance relative to the reference level
+        float mean = (float)acc->sum / count;
+        float variance = (float)acc->sum_squares / count - mean * mean;
+        float rms = variance > 0.0f ? sqrtf(variance) : 0.0f;
+        
+        float peak = fmaxf((float)acc->max - mean, mean - (float)acc->min);
+        axis->mean_mg = acc->reference + (int32_t)lroundf(mean);
+        axis->rms_mg = (uint32_t)lroundf(rms);
+        axis->peak_to_peak_mg = (uint32_t)(acc->max - acc->min);
+        axis->crest_factor = rms > 0.0f ? (uint32_t)lroundf(peak * 100.0f / rms) : 0;
+        axis->crossing_rate = (uint32_t)((uint64_t)acc->crossings * sample_rate_hz * 100 / window_count);
+        
+        // The next window is measured from this one's mean
+        acc->reference = axis->mean_mg;
+    }
+    
+    latest = features;
+    has_latest = true;
+    stats.windows++;
+    
+    if (http_send_features(&features)) {
+        stats.queued++;
+    } else {
+        stats.dropped++;
+    }
+    
+    features_restart_window();
+}
+
+
+/**
+ * @brief Clear the running totals, keeping each axis's reference level.
+ */
+static void features_restart_window(void) {
+    
+    for (uint8_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) {
+        AxisAccumulator* acc = &accumulators[i];
+        acc->sum = 0;
+        acc->sum_squares = 0;
+        acc->min = 0;
+        acc->max = 0;
+        acc->crossings = 0;
+    }
+    
+    window_count = 0;
+}
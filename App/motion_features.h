@@ -0,0 +1,79 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _MOTION_FEATURES_H_
+#define _MOTION_FEATURES_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     FEATURES_WINDOW_MS              60000
+#define     FEATURES_MIN_WINDOW_MS          1000
+#define     FEATURES_MAX_WINDOW_MS          600000
+#define     FEATURES_AXIS_COUNT             3
+
+// A zero crossing is counted only when the signal moves this far
+// past the reference level, so noise around it isn't counted
+#define     FEATURES_CROSSING_BAND_MG       20
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    int32_t     mean_mg;
+    uint32_t    rms_mg;                 // About the mean, ie. of the vibration only
+    uint32_t    peak_to_peak_mg;
+    uint32_t    crest_factor;           // Peak deviation from the mean over RMS, x100
+    uint32_t    crossing_rate;          // Crossings of the reference level per second, x100
+} AxisFeatures;         // Record for one axis's features over a window
+
+typedef struct {
+    uint32_t        tick;
+    uint32_t        samples;
+    AxisFeatures    axes[FEATURES_AXIS_COUNT];
+} MotionFeatures;       // Record for a window's features, for the X, Y and Z axes in turn
+
+typedef struct {
+    int32_t     reference;
+    int64_t     sum;
+    uint64_t    sum_squares;
+    int32_t     min;
+    int32_t     max;
+    bool        is_above;
+    uint32_t    crossings;
+} AxisAccumulator;      // Record for one axis's running totals, in mG from the reference level
+
+typedef struct {
+    uint32_t    windows;
+    uint32_t    queued;
+    uint32_t    dropped;
+} FeatureStats;         // Record for feature extraction counters
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        features_set_window(uint32_t window_ms, uint32_t rate_hz);
+uint32_t    features_add_samples(const AccelRaw* samples, uint32_t count);
+bool        features_latest(MotionFeatures* features);
+void        features_get_stats(FeatureStats* data);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _MOTION_FEATURES_H_
@@ -115,6 +115,21 @@ MvNetworkHandle net_get_handle(void) {
 }
 
 
+/**
+ * @brief Check whether the network is up.
+ *
+ * @returns `true` if Microvisor reports the network connected, otherwise `false`.
+ */
+bool net_is_connected(void) {
+    
+    if (net_handles.network == 0) return false;
+    
+    enum MvNetworkStatus net_state = MV_NETWORKSTATUS_DELIBERATELYOFFLINE;
+    enum MvStatus status = mvGetNetworkStatus(net_handles.network, &net_state);
+    return (status == MV_STATUS_OKAY && net_state == MV_NETWORKSTATUS_CONNECTED);
+}
+
+
 /**
  * @brief Network notification ISR.
  */
@@ -20,6 +20,7 @@ extern "C" {
  */
 void            net_open_network(void);
 MvNetworkHandle net_get_handle(void);
+bool            net_is_connected(void);
 
 
 #ifdef __cplusplus
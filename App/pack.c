@@ -0,0 +1,196 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/**
+ * @brief Begin a packed byte stream.
+ *
+ * @param buffer: A pointer to the record to initialize.
+ * @param data:   The memory to pack into.
+ * @param size:   The size of `data` in bytes.
+ */
+void pack_init(PackBuffer* buffer, uint8_t* data, uint32_t size) {
+    
+    buffer->data = data;
+    buffer->size = size;
+    buffer->length = 0;
+    buffer->overflow = false;
+}
+
+
+/**
+ * @brief Pack an unsigned value as a varint.
+ *
+ * Each byte carries seven bits of the value, least significant first,
+ * with the top bit set on all but the last byte. Values under 128 take
+ * one byte; a full 32-bit value takes five.
+ *
+ * Values that won't fit set the buffer's `overflow` flag, and are not packed.
+ *
+ * @param buffer: A pointer to the stream.
+ * @param value:  The value to pack.
+ */
+void pack_uint(PackBuffer* buffer, uint32_t value) {
+    
+    uint8_t bytes[PACK_MAX_VARINT_B];
+    uint32_t length = 0;
+    do {
+        bytes[length] = value & 0x7F;
+        value >>= 7;
+        if (value > 0) bytes[length] |= 0x80;
+        length++;
+    } while (value > 0);
+    
+    if (buffer->overflow || length > buffer->size - buffer->length) {
+        buffer->overflow = true;
+        return;
+    }
+    
+    memcpy(&buffer->data[buffer->length], bytes, length);
+    buffer->length += length;
+}
+
+
+/**
+ * @brief Pack a signed value as a zig-zag varint.
+ *
+ * @param buffer: A pointer to the stream.
+ * @param value:  The value to pack.
+ */
+void pack_int(PackBuffer* buffer, int32_t value) {
+    
+    pack_uint(buffer, pack_zigzag(value));
+}
+
+
+/**
+ * @brief Pack the change from the previous value in a series.
+ *
+ * Successive sensor readings are close together, so their differences
+ * are small and usually pack into a single byte.
+ *
+ * @param buffer:   A pointer to the stream.
+ * @param value:    The value to pack.
+ * @param previous: The series' previous value, updated to `value`.
+ *                  Start the series at 0, so its first value is packed whole.
+ */
+void pack_delta(PackBuffer* buffer, int32_t value, int32_t* previous) {
+    
+    // Wrap-around arithmetic, so any pair of values round-trips
+    pack_int(buffer, (int32_t)((uint32_t)value - (uint32_t)*previous));
+    *previous = value;
+}
+
+
+/**
+ * @brief Map a signed value to an unsigned one, so that values
+ *        near zero, either side, map to small numbers:
+ *        0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3...
+ *
+ * @param value: The signed value.
+ *
+ * @returns The zig-zag encoded value.
+ */
+uint32_t pack_zigzag(int32_t value) {
+    
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+
+/**
+ * @brief Begin decoding a packed byte stream.
+ *
+ * @param reader: A pointer to the record to initialize.
+ * @param data:   The packed bytes.
+ * @param length: The number of packed bytes.
+ */
+void unpack_init(PackReader* reader, const uint8_t* data, uint32_t length) {
+    
+    reader->data = data;
+    reader->length = length;
+    reader->offset = 0;
+}
+
+
+/**
+ * @brief Decode the next varint in a stream.
+ *
+ * @param reader: A pointer to the stream.
+ * @param value:  Set to the decoded value.
+ *
+ * @returns `true` if a value was decoded, or `false` at the end
+ *          of the stream or if the stream is malformed.
+ */
+bool unpack_uint(PackReader* reader, uint32_t* value) {
+    
+    uint32_t result = 0;
+    for (uint32_t i = 0 ; i < PACK_MAX_VARINT_B ; ++i) {
+        if (reader->offset >= reader->length) return false;
+        
+        uint8_t byte = reader->data[reader->offset++];
+        result |= (uint32_t)(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    
+    // Too long for 32 bits
+    return false;
+}
+
+
+/**
+ * @brief Decode the next zig-zag varint in a stream.
+ *
+ * @param reader: A pointer to the stream.
+ * @param value:  Set to the decoded value.
+ *
+ * @returns `true` if a value was decoded, otherwise `false`.
+ */
+bool unpack_int(PackReader* reader, int32_t* value) {
+    
+    uint32_t encoded = 0;
+    if (!unpack_uint(reader, &encoded)) return false;
+    *value = unpack_zigzag(encoded);
+    return true;
+}
+
+
+/**
+ * @brief Decode the next value in a series packed with `pack_delta()`.
+ *
+ * @param reader:   A pointer to the stream.
+ * @param value:    Set to the decoded value.
+ * @param previous: The series' previous value, updated to `value`.
+ *
+ * @returns `true` if a value was decoded, otherwise `false`.
+ */
+bool unpack_delta(PackReader* reader, int32_t* value, int32_t* previous) {
+    
+    int32_t delta = 0;
+    if (!unpack_int(reader, &delta)) return false;
+    *value = (int32_t)((uint32_t)*previous + (uint32_t)delta);
+    *previous = *value;
+    return true;
+}
+
+
+/**
+ * @brief Reverse `pack_zigzag()`.
+ *
+ * @param value: The zig-zag encoded value.
+ *
+ * @returns The signed value.
+ */
+int32_t unpack_zigzag(uint32_t value) {
+    
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
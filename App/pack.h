@@ -0,0 +1,62 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _PACK_H_
+#define _PACK_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     PACK_MAX_VARINT_B           5
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint8_t*    data;
+    uint32_t    size;
+    uint32_t    length;
+    bool        overflow;
+} PackBuffer;           // Record for a packed byte stream under construction
+
+typedef struct {
+    const uint8_t*  data;
+    uint32_t        length;
+    uint32_t        offset;
+} PackReader;           // Record for a packed byte stream being decoded
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        pack_init(PackBuffer* buffer, uint8_t* data, uint32_t size);
+void        pack_uint(PackBuffer* buffer, uint32_t value);
+void        pack_int(PackBuffer* buffer, int32_t value);
+void        pack_delta(PackBuffer* buffer, int32_t value, int32_t* previous);
+uint32_t    pack_zigzag(int32_t value);
+
+void        unpack_init(PackReader* reader, const uint8_t* data, uint32_t length);
+bool        unpack_uint(PackReader* reader, uint32_t* value);
+bool        unpack_int(PackReader* reader, int32_t* value);
+bool        unpack_delta(PackReader* reader, int32_t* value, int32_t* previous);
+int32_t     unpack_zigzag(uint32_t value);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _PACK_H_
@@ -0,0 +1,180 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void sampler_run_schedule(uint8_t index);
+
+
+/*
+ * GLOBALS
+ */
+// Schedules are added before the kernel starts, and only the
+// sampler task touches them after that, apart from the period,
+// which is a single word, and the stats, which readers copy
+// with the scheduler locked
+static struct {
+    const char*         name;
+    SamplerCallback     callback;
+    void*               context;
+    volatile uint32_t   period;
+    TickType_t          deadline;
+    uint64_t            total_jitter;
+    SamplerStats        stats;
+} schedules[SAMPLER_MAX_SCHEDULES];
+
+static uint8_t schedule_count = 0;
+
+
+/**
+ * @brief Add a periodic reading.
+ *
+ * Call before the kernel starts. The first reading is taken as
+ * soon as the sampler task runs.
+ *
+ * @param name:      A name for the schedule, used in logs.
+ * @param period_ms: The time between readings.
+ * @param callback:  The function that takes the reading.
+ * @param context:   Passed to `callback`.
+ *
+ * @returns The schedule's index, or -1 if there's no room for it.
+ */
+int8_t sampler_add_schedule(const char* name, uint32_t period_ms, SamplerCallback callback, void* context) {
+    
+    if (schedule_count == SAMPLER_MAX_SCHEDULES || period_ms == 0) return -1;
+    
+    schedules[schedule_count].name = name;
+    schedules[schedule_count].callback = callback;
+    schedules[schedule_count].context = context;
+    schedules[schedule_count].period = pdMS_TO_TICKS(period_ms);
+    return (int8_t)schedule_count++;
+}
+
+
+/**
+ * @brief Change a schedule's period.
+ *
+ * The reading already scheduled is taken as planned: the new
+ * period applies from that one on.
+ *
+ * @param schedule:  The schedule's index.
+ * @param period_ms: The new time between readings.
+ */
+void sampler_set_period(int8_t schedule, uint32_t period_ms) {
+    
+    if (schedule < 0 || schedule >= schedule_count || period_ms == 0) return;
+    schedules[schedule].period = pdMS_TO_TICKS(period_ms);
+}
+
+
+/**
+ * @brief Get a schedule's timing counters.
+ *
+ * @param schedule: The schedule's index.
+ * @param data:     Pointer to a SamplerStats structure.
+ *                  (see sampler.h)
+ */
+void sampler_get_stats(int8_t schedule, SamplerStats* data) {
+    
+    if (schedule < 0 || schedule >= schedule_count) return;
+    
+    osKernelLock();
+    *data = schedules[schedule].stats;
+    data->period_ms = schedules[schedule].period * portTICK_PERIOD_MS;
+    data->mean_jitter_ms = data->runs > 0 ? (uint32_t)(schedules[schedule].total_jitter / data->runs) : 0;
+    osKernelUnlock();
+}
+
+
+/**
+ * @brief Log every schedule's timing counters.
+ */
+void sampler_log_stats(void) {
+    
+    for (uint8_t i = 0 ; i < schedule_count ; ++i) {
+        SamplerStats stats;
+        sampler_get_stats(i, &stats);
+        server_log("Sampler %s: every %lu ms, %lu runs, %lu missed, jitter mean %lu ms max %lu ms",
+                   schedules[i].name, stats.period_ms, stats.runs, stats.missed,
+                   stats.mean_jitter_ms, stats.max_jitter_ms);
+    }
+}
+
+
+/**
+ * @brief Function implementing the sampler task thread.
+ *
+ * Sleeps until the earliest deadline, then takes every reading that is
+ * due. Deadlines are absolute: each is the last one plus the period, and
+ * `vTaskDelayUntil()` measures from the last wake time rather than from
+ * now, so time spent taking readings doesn't push later ones back.
+ *
+ * @param argument: Not used.
+ */
+void sampler_task(void* argument) {
+    
+    if (schedule_count == 0) osThreadExit();
+    
+    TickType_t wake = xTaskGetTickCount();
+    for (uint8_t i = 0 ; i < schedule_count ; ++i) schedules[i].deadline = wake;
+    
+    while (true) {
+        // Find the earliest deadline
+        TickType_t next = schedules[0].deadline;
+        for (uint8_t i = 1 ; i < schedule_count ; ++i) {
+            if ((int32_t)(schedules[i].deadline - next) < 0) next = schedules[i].deadline;
+        }
+        
+        // Sleep until then, unless we're already late
+        TickType_t increment = next - wake;
+        if ((int32_t)increment > 0) {
+            vTaskDelayUntil(&wake, increment);
+        } else {
+            wake = next;
+        }
+        
+        for (uint8_t i = 0 ; i < schedule_count ; ++i) {
+            if ((int32_t)(xTaskGetTickCount() - schedules[i].deadline) >= 0) sampler_run_schedule(i);
+        }
+    }
+}
+
+
+/**
+ * @brief Take a reading and set the schedule's next deadline.
+ *
+ * Jitter is the time from the deadline to the start of the reading. If
+ * we've fallen a whole period or more behind, the readings we missed are
+ * skipped and counted, rather than taken late in a burst.
+ *
+ * @param index: The schedule's index.
+ */
+static void sampler_run_schedule(uint8_t index) {
+    
+    uint32_t jitter = (uint32_t)(xTaskGetTickCount() - schedules[index].deadline) * portTICK_PERIOD_MS;
+    schedules[index].callback(schedules[index].context);
+    
+    SamplerStats* stats = &schedules[index].stats;
+    stats->runs++;
+    schedules[index].total_jitter += jitter;
+    if (jitter > stats->max_jitter_ms) stats->max_jitter_ms = jitter;
+    
+    uint32_t period = schedules[index].period;
+    schedules[index].deadline += period;
+    
+    TickType_t late = xTaskGetTickCount() - schedules[index].deadline;
+    if ((int32_t)late >= 0) {
+        uint32_t missed = late / period + 1;
+        schedules[index].deadline += missed * period;
+        stats->missed += missed;
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _SAMPLER_H_
+#define _SAMPLER_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     SAMPLER_MAX_SCHEDULES       4
+
+
+/*
+ * STRUCTURES
+ */
+// Takes a reading. Called on the sampler task, so it must not block for long
+typedef void (*SamplerCallback)(void* context);
+
+typedef struct {
+    uint32_t    period_ms;
+    uint32_t    runs;
+    uint32_t    missed;
+    uint32_t    mean_jitter_ms;
+    uint32_t    max_jitter_ms;
+} SamplerStats;         // Record for a schedule's timing counters
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+int8_t      sampler_add_schedule(const char* name, uint32_t period_ms, SamplerCallback callback, void* context);
+void        sampler_set_period(int8_t schedule, uint32_t period_ms);
+void        sampler_get_stats(int8_t schedule, SamplerStats* data);
+void        sampler_log_stats(void);
+void        sampler_task(void* argument);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _SAMPLER_H_
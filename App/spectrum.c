@@ -0,0 +1,354 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Use the Cortex-M33's DSP extension when the compiler targets it.
+// The C versions of the helpers below produce the same results
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP == 1
+#define SPECTRUM_USE_DSP        1
+#else
+#define SPECTRUM_USE_DSP        0
+#endif
+
+#define SPECTRUM_PI             3.14159265f
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void     spectrum_init_tables(void);
+static void     spectrum_process_frame(void);
+static uint8_t  spectrum_find_peaks(const uint32_t* power, uint32_t* bins);
+static void     spectrum_measure_peak(const uint32_t* power, uint32_t bin, float shift_scale, SpectrumPeak* peak);
+
+
+/*
+ * GLOBALS
+ */
+// Twiddle factors, exp(-2πik/N), and the Hann window, in Q15.
+// Complex values are packed as two halfwords, the real part low,
+// which is the operand layout of the DSP dual-multiply instructions
+static uint32_t twiddles[SPECTRUM_FFT_SIZE / 2];
+static int16_t hann[SPECTRUM_FFT_SIZE];
+static bool has_tables = false;
+
+// The frame being filled, and the transform's working buffer
+static int16_t frame[SPECTRUM_FFT_SIZE];
+static uint32_t frame_count = 0;
+static uint32_t work[SPECTRUM_FFT_SIZE];
+
+static uint8_t spectrum_axis = SPECTRUM_AXIS_Z;
+static uint32_t sample_rate_hz = MOTION_SAMPLE_RATE_HZ;
+static uint32_t frames = 0;
+
+static SpectrumResult latest;
+static bool has_latest = false;
+
+
+// Helpers for packed Q15 complex values
+static inline uint32_t spectrum_pack(int32_t re, int32_t im) {
+    
+    return (uint32_t)(uint16_t)re | ((uint32_t)(uint16_t)im << 16);
+}
+
+static inline int32_t spectrum_re(uint32_t value) {
+    
+    return (int16_t)(value & 0xFFFF);
+}
+
+static inline int32_t spectrum_im(uint32_t value) {
+    
+    return (int16_t)(value >> 16);
+}
+
+// (a + b) / 2, per halfword
+static inline uint32_t spectrum_halving_add(uint32_t a, uint32_t b) {
+    
+#if SPECTRUM_USE_DSP
+    return __SHADD16(a, b);
+#else
+    return spectrum_pack((spectrum_re(a) + spectrum_re(b)) >> 1, (spectrum_im(a) + spectrum_im(b)) >> 1);
+#endif
+}
+
+// (a - b) / 2, per halfword
+static inline uint32_t spectrum_halving_sub(uint32_t a, uint32_t b) {
+    
+#if SPECTRUM_USE_DSP
+    return __SHSUB16(a, b);
+#else
+    return spectrum_pack((spectrum_re(a) - spectrum_re(b)) >> 1, (spectrum_im(a) - spectrum_im(b)) >> 1);
+#endif
+}
+
+// a * w, where w is Q15
+static inline uint32_t spectrum_multiply(uint32_t a, uint32_t w) {
+    
+#if SPECTRUM_USE_DSP
+    int32_t re = (int32_t)__SMUSD(a, w);
+    int32_t im = (int32_t)__SMUADX(a, w);
+#else
+    int32_t re = spectrum_re(a) * spectrum_re(w) - spectrum_im(a) * spectrum_im(w);
+    int32_t im = spectrum_re(a) * spectrum_im(w) + spectrum_im(a) * spectrum_re(w);
+#endif
+    return spectrum_pack(re >> 15, im >> 15);
+}
+
+// |a|²
+static inline uint32_t spectrum_power(uint32_t a) {
+    
+#if SPECTRUM_USE_DSP
+    return __SMUAD(a, a);
+#else
+    return (uint32_t)(spectrum_re(a) * spectrum_re(a) + spectrum_im(a) * spectrum_im(a));
+#endif
+}
+
+
+/**
+ * @brief Start taking spectra of one axis of the motion stream.
+ *
+ * Samples are collected into frames of SPECTRUM_FFT_SIZE, and each
+ * frame's largest peaks are found when it fills.
+ *
+ * @param axis:    SPECTRUM_AXIS_X, SPECTRUM_AXIS_Y or SPECTRUM_AXIS_Z.
+ * @param rate_hz: The rate the motion stream is sampled at.
+ */
+void spectrum_start(uint8_t axis, uint32_t rate_hz) {
+    
+    if (!has_tables) spectrum_init_tables();
+    spectrum_axis = axis <= SPECTRUM_AXIS_Z ? axis : SPECTRUM_AXIS_Z;
+    sample_rate_hz = rate_hz;
+    frame_count = 0;
+}
+
+
+/**
+ * @brief Take samples into the current frame, and analyze each
+ *        frame that fills.
+ *
+ * @param samples: The samples, oldest first.
+ * @param count:   The number of samples.
+ *
+ * @returns The number of frames analyzed.
+ */
+uint32_t spectrum_add_samples(const AccelRaw* samples, uint32_t count) {
+    
+    if (!has_tables) return 0;
+    
+    uint32_t analyzed = 0;
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        const AccelRaw* sample = &samples[i];
+        frame[frame_count++] = spectrum_axis == SPECTRUM_AXIS_X ? sample->x : (spectrum_axis == SPECTRUM_AXIS_Y ? sample->y : sample->z);
+        if (frame_count == SPECTRUM_FFT_SIZE) {
+            spectrum_process_frame();
+            frame_count = 0;
+            analyzed++;
+        }
+    }
+    
+    return analyzed;
+}
+
+
+/**
+ * @brief Get the peaks of the most recently analyzed frame.
+ *
+ * @param result: Set to the frame's peaks, if there are any.
+ *
+ * @returns `true` if a frame has been analyzed, otherwise `false`.
+ */
+bool spectrum_latest(SpectrumResult* result) {
+    
+    if (!has_latest) return false;
+    *result = latest;
+    return true;
+}
+
+
+/**
+ * @brief Transform SPECTRUM_FFT_SIZE complex values in place.
+ *
+ * This is a radix-2 decimation-in-time FFT. Values are packed Q15,
+ * real part low. Each stage halves its outputs, so nothing overflows
+ * as long as every value's magnitude is at most 1 -- a real frame
+ * always is -- and the result is the DFT divided by SPECTRUM_FFT_SIZE.
+ * Each stage rounds down, so bins can be a few LSBs below the exact DFT's.
+ *
+ * @param data: The values, in natural order. Replaced by the bins.
+ */
+void spectrum_fft_q15(uint32_t* data) {
+    
+    if (!has_tables) spectrum_init_tables();
+    
+    // Put the input in bit-reversed order
+    uint32_t j = 0;
+    for (uint32_t i = 1 ; i < SPECTRUM_FFT_SIZE ; ++i) {
+        uint32_t bit = SPECTRUM_FFT_SIZE >> 1;
+        for ( ; j & bit ; bit >>= 1) j ^= bit;
+        j ^= bit;
+        
+        if (i < j) {
+            uint32_t swap = data[i];
+            data[i] = data[j];
+            data[j] = swap;
+        }
+    }
+    
+    // Butterflies, with each stage's twiddles spaced further apart
+    for (uint32_t size = 2 ; size <= SPECTRUM_FFT_SIZE ; size <<= 1) {
+        uint32_t half = size >> 1;
+        uint32_t step = SPECTRUM_FFT_SIZE / size;
+        for (uint32_t k = 0 ; k < half ; ++k) {
+            uint32_t twiddle = twiddles[k * step];
+            for (uint32_t top = k ; top < SPECTRUM_FFT_SIZE ; top += size) {
+                uint32_t a = data[top];
+                uint32_t b = spectrum_multiply(data[top + half], twiddle);
+                data[top] = spectrum_halving_add(a, b);
+                data[top + half] = spectrum_halving_sub(a, b);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Fill the twiddle and window tables. This runs once, at start.
+ */
+static void spectrum_init_tables(void) {
+    
+    for (uint32_t k = 0 ; k < SPECTRUM_FFT_SIZE / 2 ; ++k) {
+        float angle = 2.0f * SPECTRUM_PI * (float)k / (float)SPECTRUM_FFT_SIZE;
+        twiddles[k] = spectrum_pack(lroundf(cosf(angle) * 32767.0f), lroundf(-sinf(angle) * 32767.0f));
+    }
+    
+    for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) {
+        float angle = 2.0f * SPECTRUM_PI * (float)i / (float)SPECTRUM_FFT_SIZE;
+        hann[i] = (int16_t)lroundf((0.5f - 0.5f * cosf(angle)) * 32767.0f);
+    }
+    
+    has_tables = true;
+}
+
+
+/**
+ * @brief Window and transform the full frame, then record its peaks.
+ */
+static void spectrum_process_frame(void) {
+    
+    // Remove the mean, ie. gravity, which would otherwise swamp the spectrum
+    int32_t sum = 0;
+    for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) sum += frame[i];
+    int32_t mean = sum / SPECTRUM_FFT_SIZE;
+    
+    uint32_t largest = 0;
+    for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) {
+        int32_t value = frame[i] - mean;
+        uint32_t magnitude = (uint32_t)(value < 0 ? -value : value);
+        if (magnitude > largest) largest = magnitude;
+    }
+    
+    latest.tick = HAL_GetTick();
+    latest.frame = ++frames;
+    latest.axis = spectrum_axis;
+    latest.count = 0;
+    has_latest = true;
+    if (largest == 0) return;
+    
+    // Scale the frame to use the available bits however small the
+    // vibration is, ie. block floating point, so quiet signals
+    // aren't lost to rounding in the butterflies
+    int32_t shift = SPECTRUM_FRAME_BITS - (32 - __builtin_clz(largest));
+    for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) {
+        int32_t value = frame[i] - mean;
+        value = shift >= 0 ? value * (1 << shift) : value >> -shift;
+        work[i] = spectrum_pack((value * hann[i]) >> 15, 0);
+    }
+    
+    spectrum_fft_q15(work);
+    
+    // The input was real, so the upper bins mirror the lower ones
+    for (uint32_t k = 0 ; k < SPECTRUM_BIN_COUNT ; ++k) work[k] = spectrum_power(work[k]);
+    
+    uint32_t bins[SPECTRUM_MAX_PEAKS];
+    uint8_t count = spectrum_find_peaks(work, bins);
+    float shift_scale = ldexpf(1.0f, -shift);
+    for (uint8_t i = 0 ; i < count ; ++i) spectrum_measure_peak(work, bins[i], shift_scale, &latest.peaks[i]);
+    latest.count = count;
+}
+
+
+/**
+ * @brief Find the largest local maxima of the power spectrum.
+ *
+ * @param power: The power in each bin, 0 to SPECTRUM_BIN_COUNT - 1.
+ * @param bins:  Set to the peaks' bins, largest first.
+ *
+ * @returns The number of peaks found, up to SPECTRUM_MAX_PEAKS.
+ */
+static uint8_t spectrum_find_peaks(const uint32_t* power, uint32_t* bins) {
+    
+    uint8_t count = 0;
+    for (uint32_t k = SPECTRUM_FIRST_PEAK_BIN ; k < SPECTRUM_BIN_COUNT - 1 ; ++k) {
+        if (power[k] == 0 || power[k] <= power[k - 1] || power[k] < power[k + 1]) continue;
+        
+        // Insert the peak in order, dropping the smallest if the list is full
+        uint8_t slot = count < SPECTRUM_MAX_PEAKS ? count++ : SPECTRUM_MAX_PEAKS;
+        if (slot == SPECTRUM_MAX_PEAKS) {
+            if (power[k] <= power[bins[SPECTRUM_MAX_PEAKS - 1]]) continue;
+            slot = SPECTRUM_MAX_PEAKS - 1;
+        }
+        
+        while (slot > 0 && power[bins[slot - 1]] < power[k]) {
+            bins[slot] = bins[slot - 1];
+            slot--;
+        }
+        
+        bins[slot] = k;
+    }
+    
+    return count;
+}
+
+
+/**
+ * @brief Measure a peak's frequency and amplitude.
+ *
+ * The peak is interpolated from its bin and the bins either side,
+ * by fitting a parabola to their magnitudes, so it's located to a
+ * fraction of a bin.
+ *
+ * @param power:       The power in each bin.
+ * @param bin:         The peak's bin.
+ * @param shift_scale: The factor that undoes the frame's normalization.
+ * @param peak:        Set to the peak's frequency and amplitude.
+ */
+static void spectrum_measure_peak(const uint32_t* power, uint32_t bin, float shift_scale, SpectrumPeak* peak) {
+    
+    float before = sqrtf((float)power[bin - 1]);
+    float at = sqrtf((float)power[bin]);
+    float after = sqrtf((float)power[bin + 1]);
+    
+    float curve = before - 2.0f * at + after;
+    float offset = curve < 0.0f ? 0.5f * (before - after) / curve : 0.0f;
+    float magnitude = at - 0.25f * (before - after) * offset;
+    
+    // A sine of amplitude A shows as A/4 here: half its energy is in the
+    // mirrored bin, and the Hann window's gain is a half. Counts are then
+    // converted with the sensor's scale for its current mode and range
+    float amplitude = 4.0f * magnitude * shift_scale;
+    float mg_per_count = (float)LIS3DH_raw_to_mg(INT16_MIN) / (float)INT16_MIN;
+    
+    peak->frequency = (uint32_t)lroundf(((float)bin + offset) * (float)sample_rate_hz * 100.0f / (float)SPECTRUM_FFT_SIZE);
+    peak->amplitude_mg = (uint32_t)lroundf(amplitude * mg_per_count);
+}
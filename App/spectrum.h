@@ -0,0 +1,70 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _SPECTRUM_H_
+#define _SPECTRUM_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     SPECTRUM_FFT_LOG2               8
+#define     SPECTRUM_FFT_SIZE               (1 << SPECTRUM_FFT_LOG2)    // NOTE Size in samples, not bytes
+#define     SPECTRUM_BIN_COUNT              (SPECTRUM_FFT_SIZE / 2 + 1)
+#define     SPECTRUM_MAX_PEAKS              4
+
+// Bins this close to DC hold the window's leakage of the signal's
+// mean, which is removed before the transform, so aren't peaks
+#define     SPECTRUM_FIRST_PEAK_BIN         2
+
+// Frames are normalized so their largest sample has this many bits
+// of magnitude, leaving headroom for the complex multiplies
+#define     SPECTRUM_FRAME_BITS             14
+
+#define     SPECTRUM_AXIS_X                 0
+#define     SPECTRUM_AXIS_Y                 1
+#define     SPECTRUM_AXIS_Z                 2
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    frequency;              // Hz x100
+    uint32_t    amplitude_mg;
+} SpectrumPeak;         // Record for a spectral peak
+
+typedef struct {
+    uint32_t        tick;
+    uint32_t        frame;
+    uint8_t         axis;
+    uint8_t         count;
+    SpectrumPeak    peaks[SPECTRUM_MAX_PEAKS];
+} SpectrumResult;       // Record for a frame's largest peaks, largest first
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        spectrum_start(uint8_t axis, uint32_t rate_hz);
+uint32_t    spectrum_add_samples(const AccelRaw* samples, uint32_t count);
+bool        spectrum_latest(SpectrumResult* result);
+void        spectrum_fft_q15(uint32_t* data);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _SPECTRUM_H_
@@ -8,6 +8,9 @@
   *          the TIM time base:
   *           + Intializes the TIM peripheral to generate a Period elapsed Event each 1ms
   *           + HAL_IncTick is called inside HAL_TIM_PeriodElapsedCallback ie each 1ms
+  *           + Provides the FreeRTOS tickless idle hook, which stops the kernel
+  *             tick and stretches the TIM6 period while the CPU sleeps, and steps
+  *             uwTick and the kernel tick by the time slept when it wakes
   *
  @verbatim
   ==============================================================================
@@ -37,6 +40,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32u5xx_hal.h"
 #include "mv_syscalls.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timebase.h"
 
 /** @addtogroup STM32U5xx_HAL_Driver
   * @{
@@ -51,9 +57,11 @@
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static TIM_HandleTypeDef        TimHandle;
+static SleepStats               sleepStats;
 
 /* Private function prototypes -----------------------------------------------*/
 void TIM6_IRQHandler(void);
+static void timebase_wait_clear_of_boundary(TIM_TypeDef *tim);
 #if (USE_HAL_TIM_REGISTER_CALLBACKS == 1U)
 void TimeBase_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
 #endif
@@ -193,6 +201,162 @@ void TIM6_IRQHandler(void)
   HAL_TIM_IRQHandler(&TimHandle);
 }
 
+/**
+  * @brief  Sleep with the tick suppressed. Called by the FreeRTOS idle task
+  *         when configUSE_TICKLESS_IDLE is 2.
+  * @note   SysTick, the kernel tick, is stopped. TIM6 keeps counting in 1us
+  *         steps, but its period is stretched from 1ms to end at the kernel's
+  *         next deadline, so it wakes the CPU if nothing else does. Neither the
+  *         counter nor its prescaler is reset, so no time is lost: on waking, the
+  *         counter gives the time slept to the microsecond. uwTick and the kernel
+  *         tick are both stepped by the millisecond boundaries the counter passed,
+  *         TIM6's period is set to end at the next boundary, after which it
+  *         returns to 1ms, and SysTick is restarted to fire on that boundary too.
+  *         Millisecond boundaries are the multiples of 1000 in the counter.
+  * @param  xExpectedIdleTime Ticks until the kernel next has work to do.
+  * @retval None
+  */
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+  TIM_TypeDef *tim = TimHandle.Instance;
+  uint32_t sysTickLoad, startUs, baseUs, endUs, sleptUs, sleptMs, maxMs;
+
+  if (xExpectedIdleTime > TIMEBASE_MAX_SLEEP_MS)
+  {
+    xExpectedIdleTime = TIMEBASE_MAX_SLEEP_MS;
+  }
+
+  __disable_irq();
+  __DSB();
+  __ISB();
+
+  /* A task may have been made ready since the idle task decided to sleep */
+  if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+  {
+    __enable_irq();
+    return;
+  }
+
+  /* Stop the kernel tick. A tick that fell due before it stopped is counted
+     now, rather than left pending to run on top of the ticks stepped below */
+  sysTickLoad = SysTick->LOAD;
+  SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+  if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U)
+  {
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+    vTaskStepTick(1U);
+    xExpectedIdleTime--;
+  }
+
+  /* Don't start just short of a millisecond boundary, which the counter
+     might pass before its new period is set */
+  timebase_wait_clear_of_boundary(tim);
+
+  /* Account for a 1ms update that is due but not yet serviced */
+  if ((tim->SR & TIM_SR_UIF) != 0U)
+  {
+    tim->SR = ~TIM_SR_UIF;
+    uwTick += uwTickFreq;
+  }
+
+  /* Stretch the period to end at the deadline. The counter is 16-bit, so
+     the deadline may have to be brought forward. ARR is written directly,
+     not through its preload register */
+  startUs = tim->CNT;
+  baseUs = (startUs / 1000U) * 1000U;
+  maxMs = (0x10000U - baseUs) / 1000U;
+  if (xExpectedIdleTime > maxMs)
+  {
+    xExpectedIdleTime = maxMs;
+  }
+
+  tim->CR1 &= ~TIM_CR1_ARPE;
+  tim->ARR = baseUs + (xExpectedIdleTime * 1000U) - 1U;
+
+  __DSB();
+  __WFI();
+  __ISB();
+
+  /* How long did we sleep? If the period ended, the counter restarted from 0
+     at the deadline, so it still counts from a millisecond boundary */
+  timebase_wait_clear_of_boundary(tim);
+  endUs = tim->CNT;
+  if ((tim->SR & TIM_SR_UIF) != 0U)
+  {
+    tim->SR = ~TIM_SR_UIF;
+    endUs = tim->CNT;
+    sleptUs = (tim->ARR + 1U - startUs) + endUs;
+    sleptMs = xExpectedIdleTime + (endUs / 1000U);
+  }
+  else
+  {
+    sleptUs = endUs - startUs;
+    sleptMs = (endUs / 1000U) - (startUs / 1000U);
+  }
+
+  /* End this period at the next millisecond boundary, and preload the 1ms
+     period to take over from there */
+  tim->ARR = ((endUs / 1000U) + 1U) * 1000U - 1U;
+  tim->CR1 |= TIM_CR1_ARPE;
+  tim->ARR = TimHandle.Init.Period;
+
+  /* Catch up the HAL and kernel ticks by the same amount. The kernel can't
+     be stepped past its next deadline, so the tick that reaches the deadline
+     is left to the SysTick interrupt, which also unblocks the task waiting
+     for it without a tick's delay. Only a wake-up delayed by more than a
+     millisecond would leave the kernel behind */
+  uwTick += sleptMs * uwTickFreq;
+  if (sleptMs >= xExpectedIdleTime)
+  {
+    vTaskStepTick(xExpectedIdleTime - 1U);
+    SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+  }
+  else
+  {
+    vTaskStepTick(sleptMs);
+  }
+
+  /* Restart the kernel tick so its next period ends with TIM6's, then
+     restore its full period for the reload after that */
+  SysTick->LOAD = ((1000U - (endUs % 1000U)) * (sysTickLoad + 1U)) / 1000U - 1U;
+  SysTick->VAL = 0U;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+  SysTick->LOAD = sysTickLoad;
+
+  sleepStats.sleeps++;
+  sleepStats.slept_us += sleptUs;
+
+  /* Let the interrupt that woke us, if any, run */
+  __enable_irq();
+}
+
+/**
+  * @brief  Wait until TIM6 is at least TIMEBASE_BOUNDARY_MARGIN_US short of
+  *         its next millisecond boundary.
+  * @note   Gives the caller time to read the counter and set the period
+  *         before the counter reaches the boundary.
+  * @param  tim TIM6.
+  * @retval None
+  */
+static void timebase_wait_clear_of_boundary(TIM_TypeDef *tim)
+{
+  while ((tim->CNT % 1000U) >= (1000U - TIMEBASE_BOUNDARY_MARGIN_US))
+  {
+  }
+}
+
+/**
+  * @brief  Get the tickless idle counters.
+  * @param  data Pointer to a SleepStats structure.
+  * @retval None
+  */
+void timebase_get_sleep_stats(SleepStats *data)
+{
+  __disable_irq();
+  *data = sleepStats;
+  __enable_irq();
+}
+
 /**
   * @}
   */
@@ -0,0 +1,176 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void telemetry_upload(uint32_t tick);
+
+
+/*
+ * GLOBALS
+ */
+// Store-and-forward ring of readings waiting to be uploaded.
+// `sample_head` indexes the oldest reading. Readings stay in the
+// store until the server has accepted the request carrying them
+static TelemetrySample samples[TELEMETRY_STORE_SIZE_R];
+static uint32_t sample_head = 0;
+static uint32_t sample_count = 0;
+
+// The one upload we allow in flight at a time: the readings at the
+// head of the store, and the request that is carrying them
+static uint32_t upload_seq = 0;
+static uint32_t upload_count = 0;
+static uint32_t upload_tick = 0;
+
+static TelemetryStats stats = { 0 };
+
+
+/**
+ * @brief Add a temperature reading to the store.
+ *
+ * Readings are kept as the sensor reported them, so they take
+ * half the space and are uploaded without rounding.
+ * If the store is full, the oldest reading is evicted.
+ *
+ * @param temp_raw: The temperature as read by `MCP9808_read_raw()`.
+ * @param tick:     When it was read.
+ */
+void telemetry_add_sample(int16_t temp_raw, uint32_t tick) {
+    
+    if (sample_count == TELEMETRY_STORE_SIZE_R) {
+        sample_head = (sample_head + 1) % TELEMETRY_STORE_SIZE_R;
+        sample_count--;
+        stats.evicted++;
+        
+        // The evicted reading may be part of the upload in flight
+        if (upload_count > 0) upload_count--;
+        server_error("Telemetry store full -- %lu readings evicted", stats.evicted);
+    }
+    
+    TelemetrySample* sample = &samples[(sample_head + sample_count) % TELEMETRY_STORE_SIZE_R];
+    sample->tick = tick;
+    sample->temp = temp_raw;
+    sample_count++;
+    stats.stored++;
+}
+
+
+/**
+ * @brief Upload readings if a batch is due.
+ *
+ * A batch is due when the store holds the configured number of
+ * readings, or its oldest reading is more than TELEMETRY_BATCH_MAX_AGE_MS
+ * old. Nothing is sent while the network is down. After an outage, the
+ * backlog is drained one request at a time, no more often than every
+ * TELEMETRY_DRAIN_PERIOD_MS, so reconnecting doesn't cause a burst.
+ */
+void telemetry_service(void) {
+    
+    if (sample_count == 0 || upload_seq != 0) return;
+    
+    uint32_t tick = HAL_GetTick();
+    bool is_due = sample_count >= config_get()->batch_size;
+    if (!is_due) is_due = tick - samples[sample_head].tick >= TELEMETRY_BATCH_MAX_AGE_MS;
+    if (!is_due) return;
+    
+    if (upload_tick != 0 && tick - upload_tick < TELEMETRY_DRAIN_PERIOD_MS) return;
+    if (!net_is_connected() || http_queue_full(HTTP_LANE_BULK)) return;
+    telemetry_upload(tick);
+}
+
+
+/**
+ * @brief Record the outcome of a request.
+ *
+ * Called by the HTTP code for every request it retires. If the request
+ * was our upload and the server accepted it, its readings are removed
+ * from the store. They are also removed if the server rejected them,
+ * since resending would fail the same way. Otherwise they remain to be
+ * sent again.
+ *
+ * @param seq:     The request's sequence number.
+ * @param outcome: The request's outcome -- see http.h.
+ */
+void telemetry_request_done(uint32_t seq, uint8_t outcome) {
+    
+    if (seq != upload_seq) return;
+    
+    if (outcome == HTTP_OUTCOME_DELIVERED || outcome == HTTP_OUTCOME_REJECTED) {
+        sample_head = (sample_head + upload_count) % TELEMETRY_STORE_SIZE_R;
+        sample_count -= upload_count;
+        
+        if (outcome == HTTP_OUTCOME_DELIVERED) {
+            stats.delivered += upload_count;
+        } else {
+            stats.rejected += upload_count;
+            server_error("Telemetry upload rejected -- %lu readings discarded", upload_count);
+        }
+    } else {
+        stats.failed_uploads++;
+        server_error("Telemetry upload failed -- %lu readings retained", sample_count);
+    }
+    
+    upload_seq = 0;
+    upload_count = 0;
+}
+
+
+/**
+ * @brief Get the store-and-forward counters.
+ *
+ * @param data: Pointer to a TelemetryStats structure.
+ *              (see telemetry.h)
+ */
+void telemetry_get_stats(TelemetryStats* data) {
+    
+    *data = stats;
+    data->backlog = sample_count;
+}
+
+
+/**
+ * @brief Log the store-and-forward counters.
+ */
+void telemetry_log_stats(void) {
+    
+    TelemetryStats data;
+    telemetry_get_stats(&data);
+    server_log("Telemetry: %lu stored, %lu delivered, %lu evicted, %lu rejected, %lu failed uploads, %lu waiting",
+               data.stored, data.delivered, data.evicted, data.rejected,
+               data.failed_uploads, data.backlog);
+}
+
+
+/**
+ * @brief Queue the oldest readings for upload in a single request.
+ *
+ * @param tick: The current HAL tick.
+ */
+static void telemetry_upload(uint32_t tick) {
+    
+    // Copy out the readings in order, so the encoder
+    // doesn't need to know about the ring's wrap point
+    TelemetrySample batch[TELEMETRY_MAX_BATCH_R];
+    uint32_t count = sample_count < TELEMETRY_MAX_BATCH_R ? sample_count : TELEMETRY_MAX_BATCH_R;
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        batch[i] = samples[(sample_head + i) % TELEMETRY_STORE_SIZE_R];
+    }
+    
+    uint32_t seq = 0;
+    uint32_t sent = http_send_samples(batch, count, &seq);
+    if (sent == 0) return;
+    
+    upload_seq = seq;
+    upload_count = sent;
+    upload_tick = tick;
+    if (sample_count > sent) server_log("Telemetry backlog: %lu readings", sample_count - sent);
+}
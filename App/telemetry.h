@@ -0,0 +1,61 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     TELEMETRY_STORE_SIZE_R          256           // NOTE Size in records, not bytes
+#define     TELEMETRY_MAX_BATCH_R           32
+#define     TELEMETRY_BATCH_SIZE            8
+#define     TELEMETRY_BATCH_MAX_AGE_MS      600000
+#define     TELEMETRY_DRAIN_PERIOD_MS       5000
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    tick;
+    int16_t     temp;
+} TelemetrySample;      // Record for a timestamped raw MCP9808 reading, in 1/16 degree Celsius
+
+typedef struct {
+    uint32_t    stored;
+    uint32_t    delivered;
+    uint32_t    evicted;
+    uint32_t    rejected;
+    uint32_t    failed_uploads;
+    uint32_t    backlog;
+} TelemetryStats;       // Record for store-and-forward counters
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        telemetry_add_sample(int16_t temp_raw, uint32_t tick);
+void        telemetry_service(void);
+void        telemetry_request_done(uint32_t seq, uint8_t outcome);
+void        telemetry_get_stats(TelemetryStats* stats);
+void        telemetry_log_stats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _TELEMETRY_H_
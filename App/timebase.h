@@ -0,0 +1,48 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _TIMEBASE_H_
+#define _TIMEBASE_H_
+
+
+/*
+ * CONSTANTS
+ */
+// While the tick is suppressed, TIM6 keeps counting microseconds,
+// so its 16-bit counter can time a sleep of up to 65 ms. Its period
+// isn't changed this close to a millisecond boundary
+#define     TIMEBASE_MAX_SLEEP_MS       65
+#define     TIMEBASE_BOUNDARY_MARGIN_US 10
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    sleeps;
+    uint64_t    slept_us;
+} SleepStats;           // Record for tickless idle counters
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+void        timebase_get_sleep_stats(SleepStats* data);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _TIMEBASE_H_
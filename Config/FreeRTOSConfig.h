@@ -56,19 +56,31 @@
 #define configENABLE_TRUSTZONE                   0
 #define configRUN_FREERTOS_SECURE_ONLY           0
 #define configMINIMAL_SECURE_STACK_SIZE					( 1024 )
+/* Set by ENABLE_HARDWARE_FPU in the root CMakeLists.txt. The port enables
+   the FPU and sets FPCCR.ASPEN and LSPEN: a task's FPU registers are stacked
+   only once it has used them, and then only if an exception needs them. A
+   task that has used the FPU carries an extra 136 bytes of saved context */
+#if defined(ENABLE_HARDWARE_FPU) && ENABLE_HARDWARE_FPU == 1
+#define configENABLE_FPU                         1
+#else
 #define configENABLE_FPU                         0
+#endif
 #define configENABLE_MPU                         0
 
 #define configUSE_PREEMPTION                     1
 #define configSUPPORT_STATIC_ALLOCATION          1
 #define configSUPPORT_DYNAMIC_ALLOCATION         1
 #define configUSE_IDLE_HOOK                      0
+/* Sleep between ticks when idle. 2 means the application supplies
+   vPortSuppressTicksAndSleep(): see stm32u5xx_hal_timebase_tim_template.c */
+#define configUSE_TICKLESS_IDLE                  2
 #define configUSE_TICK_HOOK                      0
 #define configCPU_CLOCK_HZ                       ( SystemCoreClock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)2048)
-#define configTOTAL_HEAP_SIZE                    ((size_t)16384)
+/* Holds the app's task stacks, which grow with the FPU context: see main.h */
+#define configTOTAL_HEAP_SIZE                    ((size_t)17408)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_TRACE_FACILITY                 1
 #define configUSE_16_BIT_TICKS                   0
@@ -0,0 +1,269 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+#include "host_stubs.h"
+#include "mv_host.h"
+
+
+/*
+ * Measures request bodies as `http.c` builds them: their size, and the
+ * time taken to encode them. It is built twice, once for each body
+ * format, as `body_bench_json` and `body_bench_cbor`. Every body is
+ * sent to the model server in `mv_host.c` and decoded again, so the
+ * figures are only reported for bodies that carry what they should.
+ */
+
+
+/*
+ * CONSTANTS
+ */
+#define     BENCH_MIN_TIME_NS           50000000ULL
+#define     BENCH_SAMPLE_PERIOD_MS      60000
+#define     BENCH_MAX_READINGS          96
+
+#if ENABLE_CBOR_BODIES == true
+#define     BENCH_FORMAT                "CBOR"
+#else
+#define     BENCH_FORMAT                "JSON"
+#endif
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void     bench_samples(uint32_t count);
+static void     bench_features(void);
+static void     drain_requests(void);
+static bool     decode_samples(const uint8_t* body, uint32_t length, const TelemetrySample* samples, uint32_t count);
+static uint32_t decode_base64(const uint8_t* text, uint32_t length, uint8_t* data);
+static void     fail(const char* what, uint32_t value);
+
+
+/*
+ * GLOBALS
+ */
+static uint32_t failures = 0;
+static TelemetrySample samples[BENCH_MAX_READINGS];
+
+
+int main(int argc, char* argv[]) {
+
+    (void)argc;
+    (void)argv;
+
+    // Readings around 22°C, a minute apart
+    uint32_t tick = 1000;
+    int16_t temp = 22 * 16;
+    for (uint32_t i = 0 ; i < BENCH_MAX_READINGS ; ++i) {
+        samples[i].tick = tick;
+        samples[i].temp = temp;
+        tick += BENCH_SAMPLE_PERIOD_MS + (i % 3);
+        temp += (int16_t)((i * 7) % 5) - 2;
+    }
+
+    http_notification_center_setup();
+
+    printf("%s bodies: readings, body bytes, bytes per reading, encode time\n", BENCH_FORMAT);
+    static const uint32_t counts[] = { 1, 4, 8, 16, 32, BENCH_MAX_READINGS };
+    for (uint32_t i = 0 ; i < sizeof(counts) / sizeof(counts[0]) ; ++i) bench_samples(counts[i]);
+    bench_features();
+
+    if (failures > 0) {
+        printf("FAILED: %u checks\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Time the encoding of a batch of readings, and check what
+ *        the server receives.
+ *
+ * @param count: The number of readings to send.
+ */
+static void bench_samples(uint32_t count) {
+
+    // Encode a queue's worth of bodies per timed run, then send them
+    uint64_t elapsed = 0;
+    uint64_t bodies = 0;
+    uint32_t packed = 0;
+    uint32_t seq = 0;
+    do {
+        uint64_t start = host_time_ns();
+        for (uint32_t i = 0 ; i < HTTP_BULK_QUEUE_SIZE_R ; ++i) packed = http_send_samples(samples, count, &seq);
+        elapsed += host_time_ns() - start;
+        bodies += HTTP_BULK_QUEUE_SIZE_R;
+        drain_requests();
+    } while (elapsed < BENCH_MIN_TIME_NS);
+
+    MvHostServer* server = mv_host_server();
+    if (packed == 0) {
+        fail("readings not queued", count);
+        return;
+    }
+
+    if (!decode_samples(server->body, server->body_length, samples, packed)) fail("readings not decoded", count);
+
+    printf("  %3u%s %4u B %6.2f B %7.0f ns\n", packed, packed < count ? "*" : " ", server->body_length,
+           (double)server->body_length / packed, (double)elapsed / (double)bodies);
+    if (packed < count) printf("  * Only %u of %u readings fit in a body\n", packed, count);
+}
+
+
+/**
+ * @brief Time the encoding of a window's motion features.
+ */
+static void bench_features(void) {
+
+    MotionFeatures features = { .tick = 123456789, .samples = 3000 };
+    for (uint32_t i = 0 ; i < FEATURES_AXIS_COUNT ; ++i) {
+        features.axes[i] = (AxisFeatures){ .mean_mg = i == 2 ? 1003 : -12, .rms_mg = 37, .peak_to_peak_mg = 412,
+                                           .crest_factor = 283, .crossing_rate = 1250 };
+    }
+
+    uint64_t elapsed = 0;
+    uint64_t bodies = 0;
+    do {
+        uint64_t start = host_time_ns();
+        for (uint32_t i = 0 ; i < HTTP_BULK_QUEUE_SIZE_R ; ++i) {
+            if (!http_send_features(&features)) fail("features not queued", i);
+        }
+
+        elapsed += host_time_ns() - start;
+        bodies += HTTP_BULK_QUEUE_SIZE_R;
+        drain_requests();
+    } while (elapsed < BENCH_MIN_TIME_NS);
+
+    printf("  Motion features: %u B, %.0f ns\n", mv_host_server()->body_length, (double)elapsed / (double)bodies);
+}
+
+
+/**
+ * @brief Let the HTTP service send every queued request to the model server.
+ */
+static void drain_requests(void) {
+
+    HttpLaneStats stats;
+    for (uint32_t i = 0 ; i <= HTTP_BULK_QUEUE_SIZE_R ; ++i) {
+        mv_host_deliver();
+        http_get_lane_stats(HTTP_LANE_BULK, &stats);
+        if (stats.depth == 0) return;
+    }
+
+    fail("requests not sent", stats.depth);
+}
+
+
+/**
+ * @brief Decode a readings body and compare it with the readings sent.
+ *
+ * @param body:    The body the server received.
+ * @param length:  The body's length in bytes.
+ * @param samples: The readings that were sent.
+ * @param count:   The number of readings the body should carry.
+ *
+ * @returns `true` if the body carries the readings exactly, otherwise `false`.
+ */
+static bool decode_samples(const uint8_t* body, uint32_t length, const TelemetrySample* samples, uint32_t count) {
+
+    uint8_t data[HTTP_MAX_BODY_LEN_B];
+    uint32_t data_length = 0;
+
+#if ENABLE_CBOR_BODIES == true
+    // A one-entry map, "packed", then the byte string's head
+    static const uint8_t prefix[] = { CBOR_MAJOR_MAP | 1, CBOR_MAJOR_TEXT | 6, 'p', 'a', 'c', 'k', 'e', 'd' };
+    if (length < sizeof(prefix) + 1 || memcmp(body, prefix, sizeof(prefix)) != 0) return false;
+
+    uint32_t offset = sizeof(prefix);
+    uint8_t head = body[offset++];
+    if ((head & 0xE0) != CBOR_MAJOR_BYTES) return false;
+    data_length = head & 0x1F;
+    if (data_length == 24) {
+        data_length = body[offset++];
+    } else if (data_length == 25) {
+        data_length = (body[offset] << 8) | body[offset + 1];
+        offset += 2;
+    } else if (data_length > 23) {
+        return false;
+    }
+
+    if (offset + data_length != length || data_length > sizeof(data)) return false;
+    memcpy(data, &body[offset], data_length);
+#else
+    static const char prefix[] = "{\"packed\":\"";
+    static const char suffix[] = "\"}";
+    uint32_t prefix_length = sizeof(prefix) - 1;
+    uint32_t suffix_length = sizeof(suffix) - 1;
+    if (length < prefix_length + suffix_length || memcmp(body, prefix, prefix_length) != 0 ||
+        memcmp(&body[length - suffix_length], suffix, suffix_length) != 0) return false;
+
+    uint32_t text_length = length - prefix_length - suffix_length;
+    if (text_length % 4 != 0 || text_length / 4 * 3 > sizeof(data)) return false;
+    data_length = decode_base64(&body[prefix_length], text_length, data);
+#endif
+
+    PackReader reader;
+    unpack_init(&reader, data, data_length);
+    int32_t last_tick = 0;
+    int32_t last_temp = 0;
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        int32_t tick = 0;
+        int32_t temp = 0;
+        if (!unpack_delta(&reader, &tick, &last_tick) || (uint32_t)tick != samples[i].tick) return false;
+        if (!unpack_delta(&reader, &temp, &last_temp) || temp != samples[i].temp) return false;
+    }
+
+    return reader.offset == data_length;
+}
+
+
+/**
+ * @brief Decode padded base64 text.
+ *
+ * @param text:   The text, a multiple of four characters long.
+ * @param length: The text's length.
+ * @param data:   Set to the decoded bytes.
+ *
+ * @returns The number of decoded bytes.
+ */
+static uint32_t decode_base64(const uint8_t* text, uint32_t length, uint8_t* data) {
+
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    uint32_t count = 0;
+    for (uint32_t i = 0 ; i < length ; i += 4) {
+        uint32_t group = 0;
+        uint32_t padding = 0;
+        for (uint32_t j = 0 ; j < 4 ; ++j) {
+            const char* found = text[i + j] == '=' ? NULL : strchr(alphabet, text[i + j]);
+            if (found == NULL) padding++;
+            group = (group << 6) | (found != NULL ? (uint32_t)(found - alphabet) : 0);
+        }
+
+        data[count++] = (uint8_t)(group >> 16);
+        if (padding < 2) data[count++] = (uint8_t)(group >> 8);
+        if (padding < 1) data[count++] = (uint8_t)group;
+    }
+
+    return count;
+}
+
+
+/**
+ * @brief Report a failed check.
+ *
+ * @param what:  The check.
+ * @param value: The value that failed it.
+ */
+static void fail(const char* what, uint32_t value) {
+
+    failures++;
+    printf("FAIL %s: %u\n", what, value);
+}
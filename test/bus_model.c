@@ -0,0 +1,366 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+#include "host_stubs.h"
+#include "i2c_bus.h"
+
+
+/*
+ * Runs the sensor and display drivers' operations over the bus model
+ * in `stubs/i2c_bus.c`, and counts the I2C transactions each one takes
+ * against the transactions it would take without repeated-START reads
+ * and burst writes. The counts are checked against those expected, so
+ * a driver change that adds bus traffic fails the test.
+ *
+ * Every operation is run twice: before the scheduler starts, when
+ * `i2c.c` polls the HAL, and with the scheduler running, when it
+ * queues transactions for the I2C interrupt. The counts must match.
+ * Then, while another task holds the bus, LIS3DH operations must be
+ * skipped and leave the register shadow as it was. Last, with the
+ * scheduler locked, a transfer must fail while the interrupt has a
+ * transaction under way, and poll once it has not.
+ */
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    const char*     name;
+    void            (*run)(void);
+    uint32_t        transactions;
+} DriverOp;             // Record for a driver operation and its expected transaction count
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void     run_ops(const char* mode);
+static void     check_results(void);
+static void     check_contended(void);
+static void     check_locked(void);
+static void     fail(const char* what, const char* op, uint32_t value);
+
+static void     op_lis3dh_reset(void);
+static void     op_lis3dh_set_mode(void);
+static void     op_lis3dh_set_data_rate(void);
+static void     op_lis3dh_configure_click_irq(void);
+static void     op_lis3dh_configure_irq_latching(void);
+static void     op_lis3dh_configure_inertial_irq(void);
+static void     op_lis3dh_configure_fifo(void);
+static void     op_lis3dh_get_interrupt_table(void);
+static void     op_lis3dh_get_accel_raw(void);
+static void     op_lis3dh_read_fifo(void);
+static void     op_lis3dh_verify_registers(void);
+static void     op_mcp9808_read_raw(void);
+static void     op_ht16k33_draw(void);
+static void     op_ht16k33_set_brightness(void);
+
+
+/*
+ * GLOBALS
+ */
+static uint32_t failures = 0;
+
+static I2CBusDevice* mcp9808 = NULL;
+static I2CBusDevice* lis3dh = NULL;
+static I2CBusDevice* ht16k33 = NULL;
+
+static int16_t temp_raw = 0;
+static AccelRaw accel = { 0 };
+
+// Operations in the order the firmware first runs them. Each
+// LIS3DH_reset() restores the driver's register shadow, so
+// each run of the list starts from the same state
+static const DriverOp ops[] = {
+    { "LIS3DH_reset",                   op_lis3dh_reset,                    6 },
+    { "LIS3DH_set_mode",                op_lis3dh_set_mode,                 0 },
+    { "LIS3DH_set_data_rate",           op_lis3dh_set_data_rate,            1 },
+    { "LIS3DH_configure_click_irq",     op_lis3dh_configure_click_irq,      3 },
+    { "LIS3DH_configure_irq_latching",  op_lis3dh_configure_irq_latching,   2 },
+    { "LIS3DH_configure_inertial_irq",  op_lis3dh_configure_inertial_irq,   2 },
+    { "LIS3DH_configure_fifo",          op_lis3dh_configure_fifo,           2 },
+    { "LIS3DH_get_interrupt_table",     op_lis3dh_get_interrupt_table,      2 },
+    { "LIS3DH_get_accel_raw",           op_lis3dh_get_accel_raw,            1 },
+    { "LIS3DH_read_fifo",               op_lis3dh_read_fifo,                2 },
+    { "LIS3DH_verify_registers",        op_lis3dh_verify_registers,         6 },
+    { "MCP9808_read_raw",               op_mcp9808_read_raw,                1 },
+    { "HT16K33_draw",                   op_ht16k33_draw,                    1 },
+    { "HT16K33_set_brightness",         op_ht16k33_set_brightness,          1 }
+};
+
+
+int main(int argc, char* argv[]) {
+
+    (void)argc;
+    (void)argv;
+
+    // The MCP9808's registers are 16 bits wide. The LIS3DH steps through
+    // registers only if the address's top bit is set, and its driver
+    // used to write each register separately
+    mcp9808 = i2c_bus_add(MCP9808_ADDR, 2, 0, false);
+    lis3dh = i2c_bus_add(LIS3DH_ADDR, 1, LIS3DH_AUTO_INCREMENT, true);
+    ht16k33 = i2c_bus_add(HT16K33_I2C_ADDR, 1, 0, false);
+
+    // 23.0625°C, with the alert flags set
+    mcp9808->regs[MCP9808_REG_AMBIENT_TEMP * 2] = 0xE1;
+    mcp9808->regs[MCP9808_REG_AMBIENT_TEMP * 2 + 1] = 0x71;
+    lis3dh->regs[LIS3DH_WHO_AM_I] = 0x33;
+    static const uint8_t axes[6] = { 0x40, 0x01, 0xC0, 0xFE, 0x00, 0x40 };
+    memcpy(&lis3dh->regs[LIS3DH_OUT_X_L], axes, sizeof(axes));
+    lis3dh->regs[LIS3DH_FIFO_SRC_REG] = 0x80 | 25;
+
+    I2C_init();
+    run_ops("Polled, before the scheduler starts");
+    check_results();
+
+    I2C_init_arbiter();
+    host_kernel_state = osKernelRunning;
+    run_ops("Interrupt-driven, with the scheduler running");
+    check_results();
+    check_contended();
+    check_locked();
+
+    if (failures > 0) {
+        printf("FAILED: %u checks\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
+
+
+/**
+ * @brief Run every operation, and report and check its bus traffic.
+ *
+ * @param mode: How `i2c.c` is running transactions, for the report.
+ */
+static void run_ops(const char* mode) {
+
+    printf("%s:\n", mode);
+    printf("  %-32s %12s %10s %6s %6s\n", "Operation", "Transactions", "Unbatched", "Saved", "Bytes");
+
+    I2CBusCounts totals = { 0 };
+    for (uint32_t i = 0 ; i < sizeof(ops) / sizeof(ops[0]) ; ++i) {
+        I2CBusCounts counts;
+        i2c_bus_reset_counts();
+        ops[i].run();
+        i2c_bus_get_counts(&counts);
+
+        printf("  %-32s %12u %10u %6u %6u\n", ops[i].name, counts.transactions, counts.unbatched,
+               counts.unbatched - counts.transactions, counts.bytes);
+        if (counts.transactions != ops[i].transactions) fail("transactions", ops[i].name, counts.transactions);
+        if (counts.hal_calls != counts.transactions) fail("HAL calls per transaction", ops[i].name, counts.hal_calls);
+
+        totals.transactions += counts.transactions;
+        totals.unbatched += counts.unbatched;
+        totals.bytes += counts.bytes;
+    }
+
+    printf("  %-32s %12u %10u %6u %6u\n", "Total", totals.transactions, totals.unbatched,
+           totals.unbatched - totals.transactions, totals.bytes);
+}
+
+
+/**
+ * @brief Check that the operations moved the right data.
+ */
+static void check_results(void) {
+
+    if (temp_raw != 0x171) fail("MCP9808 reading", "MCP9808_read_raw", (uint16_t)temp_raw);
+    if (accel.x != 0x0140 || accel.y != (int16_t)0xFEC0 || accel.z != 0x4000) fail("LIS3DH reading", "LIS3DH_get_accel_raw", (uint16_t)accel.x);
+
+    // The reset's defaults, then the configuration written over them
+    if (lis3dh->regs[LIS3DH_CTRL_REG1] != 0x57) fail("LIS3DH register", "LIS3DH_set_data_rate", lis3dh->regs[LIS3DH_CTRL_REG1]);
+    if (lis3dh->regs[LIS3DH_CLICK_CFG] != LIS3DH_SINGLE_CLICK) fail("LIS3DH register", "LIS3DH_configure_click_irq", lis3dh->regs[LIS3DH_CLICK_CFG]);
+    if (lis3dh->regs[LIS3DH_TIME_LIMIT] != 5 || lis3dh->regs[LIS3DH_TIME_LATENCY] != 10 || lis3dh->regs[LIS3DH_TIME_WINDOW] != 50) {
+        fail("LIS3DH register", "LIS3DH_configure_click_irq", lis3dh->regs[LIS3DH_TIME_LIMIT]);
+    }
+
+    if (LIS3DH_verify_registers(false) != 0) fail("LIS3DH shadow", "LIS3DH_verify_registers", 1);
+
+    // The display RAM takes the digits
+    if (ht16k33->regs[0] == 0 && ht16k33->regs[2] == 0) fail("HT16K33 RAM", "HT16K33_draw", 0);
+}
+
+
+/**
+ * @brief Check LIS3DH operations attempted while another task holds the bus.
+ */
+static void check_contended(void) {
+
+    // Act as another task to take the bus, and keep it
+    osThreadId_t self = host_thread;
+    host_thread = (osThreadId_t)2;
+    if (!I2C_begin_batch(LIS3DH_ADDR, 100)) fail("bus not taken", "I2C_begin_batch", 0);
+    host_thread = self;
+
+    uint8_t ctrl_reg1 = lis3dh->regs[LIS3DH_CTRL_REG1];
+    AccelRaw samples[LIS3DH_FIFO_SIZE];
+    bool overrun = true;
+    i2c_bus_reset_counts();
+    uint32_t rate = LIS3DH_set_data_rate(400);
+    uint8_t count = LIS3DH_read_fifo(samples, LIS3DH_FIFO_SIZE, &overrun);
+
+    I2CBusCounts counts;
+    i2c_bus_get_counts(&counts);
+    if (rate != 0) fail("rate with the bus held", "LIS3DH_set_data_rate", rate);
+    if (count != 0 || overrun) fail("samples with the bus held", "LIS3DH_read_fifo", count);
+    if (counts.transactions != 0) fail("transactions with the bus held", "LIS3DH_set_data_rate", counts.transactions);
+
+    host_thread = (osThreadId_t)2;
+    I2C_end_batch();
+    host_thread = self;
+
+    // The skipped update must not have changed the shadow
+    if (LIS3DH_verify_registers(false) != 0 || lis3dh->regs[LIS3DH_CTRL_REG1] != ctrl_reg1) {
+        fail("LIS3DH shadow after a skipped update", "LIS3DH_set_data_rate", lis3dh->regs[LIS3DH_CTRL_REG1]);
+    }
+}
+
+
+/**
+ * @brief Check transfers made with the scheduler locked.
+ */
+static void check_locked(void) {
+
+    // Queue a read, but don't let its interrupt fire yet
+    uint8_t who_am_i = 0;
+    I2CTransaction transaction = {
+        .addr = LIS3DH_ADDR,
+        .is_register = true,
+        .reg = LIS3DH_WHO_AM_I,
+        .rx = &who_am_i,
+        .rx_length = 1
+    };
+
+    if (!I2C_submit(&transaction)) fail("transaction not queued", "I2C_submit", 0);
+
+    uint8_t data = 0;
+    osKernelLock();
+    HAL_StatusTypeDef status = I2C_read_regs(MCP9808_ADDR, MCP9808_REG_AMBIENT_TEMP, &data, 1, 100);
+    if (status != HAL_BUSY) fail("locked transfer over a queued one", "I2C_read_regs", status);
+
+    i2c_bus_interrupt();
+    if (!transaction.is_done || who_am_i != 0x33) fail("queued transaction", "I2C_submit", who_am_i);
+
+    i2c_bus_reset_counts();
+    status = I2C_read_regs(MCP9808_ADDR, MCP9808_REG_AMBIENT_TEMP, &data, 1, 100);
+    osKernelUnlock();
+
+    I2CBusCounts counts;
+    i2c_bus_get_counts(&counts);
+    if (status != HAL_OK || data != 0xE1 || counts.transactions != 1) fail("locked transfer on an idle bus", "I2C_read_regs", status);
+}
+
+
+/**
+ * @brief Report a failed check.
+ *
+ * @param what:  The check.
+ * @param op:    The operation that failed it.
+ * @param value: The value that failed it.
+ */
+static void fail(const char* what, const char* op, uint32_t value) {
+
+    failures++;
+    printf("FAIL %s, %s: %u\n", what, op, value);
+}
+
+
+/*
+ * The operations, with the arguments the firmware uses
+ */
+static void op_lis3dh_reset(void) {
+
+    LIS3DH_reset();
+}
+
+
+static void op_lis3dh_set_mode(void) {
+
+    LIS3DH_set_mode(LIS3DH_MODE_NORMAL);
+}
+
+
+static void op_lis3dh_set_data_rate(void) {
+
+    LIS3DH_set_data_rate(100);
+}
+
+
+static void op_lis3dh_configure_click_irq(void) {
+
+    LIS3DH_configure_click_irq(true, LIS3DH_SINGLE_CLICK, 1100, 5, 10, 50);
+}
+
+
+static void op_lis3dh_configure_irq_latching(void) {
+
+    LIS3DH_configure_irq_latching(true);
+}
+
+
+static void op_lis3dh_configure_inertial_irq(void) {
+
+    LIS3DH_configure_inertial_irq(true, 500, 5, 0x2A);
+}
+
+
+static void op_lis3dh_configure_fifo(void) {
+
+    LIS3DH_configure_fifo(true, LIS3DH_FIFO_STREAM_MODE);
+}
+
+
+static void op_lis3dh_get_interrupt_table(void) {
+
+    InterruptTable table;
+    LIS3DH_get_interrupt_table(&table);
+}
+
+
+static void op_lis3dh_get_accel_raw(void) {
+
+    LIS3DH_get_accel_raw(&accel);
+}
+
+
+static void op_lis3dh_read_fifo(void) {
+
+    AccelRaw samples[LIS3DH_FIFO_SIZE];
+    bool overrun = false;
+    LIS3DH_read_fifo(samples, LIS3DH_FIFO_SIZE, &overrun);
+}
+
+
+static void op_lis3dh_verify_registers(void) {
+
+    LIS3DH_verify_registers(true);
+}
+
+
+static void op_mcp9808_read_raw(void) {
+
+    MCP9808_read_raw(&temp_raw);
+}
+
+
+static void op_ht16k33_draw(void) {
+
+    HT16K33_show_value(2306, true);
+    HT16K33_draw();
+}
+
+
+static void op_ht16k33_set_brightness(void) {
+
+    HT16K33_set_brightness(2);
+}
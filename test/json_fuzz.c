@@ -0,0 +1,431 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+#include "host_stubs.h"
+
+
+/*
+ * Checks, fuzzes and times the settings update path: `json.c`
+ * tokenizing a response body, and `config.c` applying its values.
+ *
+ * Usage: json_fuzz [fuzz iterations]
+ */
+
+
+/*
+ * CONSTANTS
+ */
+#define     FUZZ_DEFAULT_ITERATIONS     20000
+#define     FUZZ_MAX_DOC_B              256
+#define     FUZZ_SEED                   0x2545F491
+#define     BENCH_MIN_TIME_NS           200000000ULL
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    bool            is_valid;
+    uint32_t        changes;
+    DeviceConfig    staged;
+} ParseResult;          // Record for the outcome of parsing one document
+
+typedef struct {
+    const char*     doc;
+    bool            is_valid;
+    uint32_t        changes;
+    const char*     field;
+    uint32_t        value;
+} KnownCase;            // Record for a document with a known outcome
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void     parse_document(const uint8_t* doc, uint32_t length, const uint32_t* splits, uint32_t split_count, ParseResult* result);
+static bool     results_match(const ParseResult* a, const ParseResult* b);
+static bool     config_in_range(const DeviceConfig* config);
+static uint32_t config_field(const DeviceConfig* config, const char* field);
+static void     check_known_cases(void);
+static void     check_chunking(const char* doc);
+static void     fuzz(uint32_t iterations);
+static uint32_t fuzz_make_document(uint8_t* doc);
+static uint32_t fuzz_random(void);
+static void     bench_throughput(void);
+static void     fail(const char* what, const uint8_t* doc, uint32_t length);
+
+
+/*
+ * GLOBALS
+ */
+static uint32_t failures = 0;
+static uint32_t rng_state = FUZZ_SEED;
+
+static const KnownCase known_cases[] = {
+    { "{\"sample_period_ms\":5000}",                true,  1, "sample_period_ms", 5000 },
+    { "{\"batch_size\":12}",                        true,  1, "batch_size", 12 },
+    { "{\"click_threshold\":1.25}",                 true,  1, "click_threshold_mg", 1250 },
+    { "{\"brightness\":0}",                         true,  1, "brightness", 0 },
+    { "{\"feature_window_ms\":10000}",              true,  1, "feature_window_ms", 10000 },
+    { "{\"temp_filters\":7,\"accel_filters\":2}",   true,  2, "accel_filters", 2 },
+    { " { \"brightness\" : 3 , \"x\" : [1,{}] } ",  true,  1, "brightness", 3 },
+
+    // Integer settings must be whole integers
+    { "{\"brightness\":1.9}",                       true,  0, NULL, 0 },
+    { "{\"batch_size\":1e1}",                       true,  0, NULL, 0 },
+    { "{\"sample_period_ms\":99999999999999999999}", true, 0, NULL, 0 },
+    { "{\"brightness\":\"12\"}",                    true,  0, NULL, 0 },
+
+    // Numbers too long for the parser are ignored, not cut short:
+    // this one would be read as 1.0 without its exponent
+    { "{\"click_threshold\":1.000000000000000000000000000000e5}", true, 0, NULL, 0 },
+
+    // Out of range, or not at the top level
+    { "{\"brightness\":16}",                        true,  0, NULL, 0 },
+    { "{\"batch_size\":0}",                         true,  0, NULL, 0 },
+    { "{\"sample_period_ms\":-5000}",               true,  0, NULL, 0 },
+    { "{\"click_threshold\":17}",                   true,  0, NULL, 0 },
+    { "{\"x\":{\"brightness\":3}}",                 true,  0, NULL, 0 },
+    { "[{\"brightness\":3}]",                       true,  0, NULL, 0 },
+
+    // Malformed
+    { "{\"brightness\":3",                          false, 1, NULL, 0 },
+    { "{\"brightness\":12abc}",                     false, 0, NULL, 0 },
+    { "{\"brightness\":03}",                        false, 0, NULL, 0 },
+    { "{\"brightness\" 3}",                         false, 0, NULL, 0 },
+    { "{\"a\":1,}",                                 false, 0, NULL, 0 },
+    { "{\"a\":[1,2}",                               false, 0, NULL, 0 },
+    { "{} {}",                                      false, 0, NULL, 0 },
+    { "[[[[[[[[[]]]]]]]]]",                         false, 0, NULL, 0 },
+    { "",                                           false, 0, NULL, 0 }
+};
+
+// Starting points for mutation
+static const char* const corpus[] = {
+    "{\"sample_period_ms\":60000,\"batch_size\":8,\"click_threshold\":1.1,\"brightness\":15}",
+    "{\"feature_window_ms\":5000,\"temp_filters\":5,\"accel_filters\":0}",
+    "{\"status\":\"ok\",\"settings\":{\"brightness\":2},\"list\":[true,false,null,-1.5e-3]}",
+    "{\"text\":\"esc \\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u00e9\"}",
+    "[1,[2,[3,[4,[5,[6,[7]]]]]]]"
+};
+
+// Characters that mutations insert: mostly JSON syntax
+static const char mutation_chars[] = "{}[]:,\"\\-+.eE0123456789tfnlrusa \t\n";
+
+
+int main(int argc, char* argv[]) {
+
+    uint32_t iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : FUZZ_DEFAULT_ITERATIONS;
+
+    check_known_cases();
+    for (uint32_t i = 0 ; i < sizeof(corpus) / sizeof(corpus[0]) ; ++i) check_chunking(corpus[i]);
+    fuzz(iterations);
+    bench_throughput();
+
+    if (failures > 0) {
+        printf("FAILED: %u checks\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
+
+
+/**
+ * @brief Parse a document as a settings update, without applying it.
+ *
+ * @param doc:         The document's bytes.
+ * @param length:      The number of bytes in the document.
+ * @param splits:      Offsets at which to break the document into chunks, ascending.
+ * @param split_count: The number of offsets.
+ * @param result:      Set to the outcome.
+ */
+static void parse_document(const uint8_t* doc, uint32_t length, const uint32_t* splits, uint32_t split_count, ParseResult* result) {
+
+    ConfigUpdate update;
+    config_update_begin(&update);
+
+    uint32_t start = 0;
+    for (uint32_t i = 0 ; i <= split_count ; ++i) {
+        uint32_t end = i < split_count ? splits[i] : length;
+        config_update_feed(&update, doc + start, end - start);
+        start = end;
+    }
+
+    result->is_valid = json_finish(&update.parser);
+    result->changes = update.changes;
+    result->staged = update.staged;
+}
+
+
+/**
+ * @brief Compare two parse outcomes.
+ *
+ * @returns `true` if they are the same, otherwise `false`.
+ */
+static bool results_match(const ParseResult* a, const ParseResult* b) {
+
+    const DeviceConfig* x = &a->staged;
+    const DeviceConfig* y = &b->staged;
+    return a->is_valid == b->is_valid && a->changes == b->changes &&
+           x->sample_period_ms == y->sample_period_ms && x->batch_size == y->batch_size &&
+           x->click_threshold_mg == y->click_threshold_mg && x->brightness == y->brightness &&
+           x->feature_window_ms == y->feature_window_ms && x->temp_filters == y->temp_filters &&
+           x->accel_filters == y->accel_filters;
+}
+
+
+/**
+ * @brief Check that every setting is within the range `config.c` enforces.
+ *
+ * @returns `true` if they all are, otherwise `false`.
+ */
+static bool config_in_range(const DeviceConfig* config) {
+
+    return config->sample_period_ms >= CONFIG_MIN_SAMPLE_PERIOD_MS && config->sample_period_ms <= CONFIG_MAX_SAMPLE_PERIOD_MS &&
+           config->batch_size >= 1 && config->batch_size <= TELEMETRY_MAX_BATCH_R &&
+           config->click_threshold_mg > 0 && config->click_threshold_mg <= CONFIG_MAX_CLICK_THRESHOLD_MG &&
+           config->brightness <= CONFIG_MAX_BRIGHTNESS &&
+           config->feature_window_ms >= FEATURES_MIN_WINDOW_MS && config->feature_window_ms <= FEATURES_MAX_WINDOW_MS &&
+           config->temp_filters <= FILTER_STAGE_ALL && config->accel_filters <= FILTER_STAGE_ALL;
+}
+
+
+/**
+ * @brief Get a setting by its field name.
+ *
+ * @returns The setting's value.
+ */
+static uint32_t config_field(const DeviceConfig* config, const char* field) {
+
+    if (strcmp(field, "sample_period_ms") == 0) return config->sample_period_ms;
+    if (strcmp(field, "batch_size") == 0) return config->batch_size;
+    if (strcmp(field, "click_threshold_mg") == 0) return config->click_threshold_mg;
+    if (strcmp(field, "brightness") == 0) return config->brightness;
+    if (strcmp(field, "feature_window_ms") == 0) return config->feature_window_ms;
+    if (strcmp(field, "temp_filters") == 0) return config->temp_filters;
+    if (strcmp(field, "accel_filters") == 0) return config->accel_filters;
+    return UINT32_MAX;
+}
+
+
+/**
+ * @brief Parse documents with known outcomes, whole and in chunks.
+ */
+static void check_known_cases(void) {
+
+    for (uint32_t i = 0 ; i < sizeof(known_cases) / sizeof(known_cases[0]) ; ++i) {
+        const KnownCase* known = &known_cases[i];
+        const uint8_t* doc = (const uint8_t*)known->doc;
+        uint32_t length = (uint32_t)strlen(known->doc);
+
+        ParseResult result;
+        parse_document(doc, length, NULL, 0, &result);
+        if (result.is_valid != known->is_valid || result.changes != known->changes) {
+            fail("known case outcome", doc, length);
+        } else if (known->field != NULL && config_field(&result.staged, known->field) != known->value) {
+            fail("known case value", doc, length);
+        }
+
+        check_chunking(known->doc);
+    }
+
+    printf("Known cases: %zu documents\n", sizeof(known_cases) / sizeof(known_cases[0]));
+}
+
+
+/**
+ * @brief Check that a document parses the same whole, split in two
+ *        at every offset, and fed a byte at a time.
+ *
+ * @param doc: The document.
+ */
+static void check_chunking(const char* doc) {
+
+    uint32_t length = (uint32_t)strlen(doc);
+    ParseResult whole, split;
+    parse_document((const uint8_t*)doc, length, NULL, 0, &whole);
+
+    for (uint32_t offset = 0 ; offset <= length ; ++offset) {
+        parse_document((const uint8_t*)doc, length, &offset, 1, &split);
+        if (!results_match(&whole, &split)) fail("two-chunk parse differs", (const uint8_t*)doc, length);
+    }
+
+    uint32_t splits[FUZZ_MAX_DOC_B];
+    for (uint32_t i = 0 ; i < length && i < FUZZ_MAX_DOC_B ; ++i) splits[i] = i;
+    parse_document((const uint8_t*)doc, length, splits, length < FUZZ_MAX_DOC_B ? length : FUZZ_MAX_DOC_B, &split);
+    if (!results_match(&whole, &split)) fail("byte-at-a-time parse differs", (const uint8_t*)doc, length);
+}
+
+
+/**
+ * @brief Parse mutated and random documents in random chunks.
+ *
+ * Every document must parse the same however it's chunked, and leave
+ * every setting in range. Memory errors are caught by the sanitizers.
+ *
+ * @param iterations: The number of documents to try.
+ */
+static void fuzz(uint32_t iterations) {
+
+    uint8_t doc[FUZZ_MAX_DOC_B];
+    uint32_t valid = 0;
+    uint32_t changed = 0;
+
+    for (uint32_t i = 0 ; i < iterations ; ++i) {
+        uint32_t length = fuzz_make_document(doc);
+
+        ParseResult whole, chunked;
+        parse_document(doc, length, NULL, 0, &whole);
+
+        uint32_t splits[8];
+        uint32_t split_count = length > 0 ? fuzz_random() % 8 : 0;
+        for (uint32_t j = 0 ; j < split_count ; ++j) splits[j] = fuzz_random() % (length + 1);
+        for (uint32_t j = 1 ; j < split_count ; ++j) {
+            // Insertion sort: the offsets must ascend
+            for (uint32_t k = j ; k > 0 && splits[k - 1] > splits[k] ; --k) {
+                uint32_t swap = splits[k];
+                splits[k] = splits[k - 1];
+                splits[k - 1] = swap;
+            }
+        }
+
+        parse_document(doc, length, splits, split_count, &chunked);
+        if (!results_match(&whole, &chunked)) fail("fuzz: chunked parse differs", doc, length);
+        if (!config_in_range(&whole.staged)) fail("fuzz: setting out of range", doc, length);
+        if (whole.is_valid) valid++;
+        if (whole.is_valid && whole.changes > 0) changed++;
+    }
+
+    printf("Fuzz: %u documents, %u valid, %u changing settings\n", iterations, valid, changed);
+}
+
+
+/**
+ * @brief Make a document to fuzz with: a corpus document with a few
+ *        random edits, or a run of random characters.
+ *
+ * @param doc: A buffer of FUZZ_MAX_DOC_B bytes.
+ *
+ * @returns The document's length.
+ */
+static uint32_t fuzz_make_document(uint8_t* doc) {
+
+    if (fuzz_random() % 8 == 0) {
+        uint32_t length = fuzz_random() % FUZZ_MAX_DOC_B;
+        for (uint32_t i = 0 ; i < length ; ++i) {
+            doc[i] = fuzz_random() % 4 == 0 ? (uint8_t)fuzz_random() : (uint8_t)mutation_chars[fuzz_random() % (sizeof(mutation_chars) - 1)];
+        }
+
+        return length;
+    }
+
+    const char* seed = corpus[fuzz_random() % (sizeof(corpus) / sizeof(corpus[0]))];
+    uint32_t length = (uint32_t)strlen(seed);
+    memcpy(doc, seed, length);
+
+    uint32_t edits = 1 + fuzz_random() % 4;
+    for (uint32_t i = 0 ; i < edits ; ++i) {
+        uint32_t at = length > 0 ? fuzz_random() % length : 0;
+        uint8_t c = fuzz_random() % 8 == 0 ? (uint8_t)fuzz_random() : (uint8_t)mutation_chars[fuzz_random() % (sizeof(mutation_chars) - 1)];
+        switch (fuzz_random() % 3) {
+            case 0:
+                // Replace a byte
+                if (length > 0) doc[at] = c;
+                break;
+            case 1:
+                // Insert a byte
+                if (length < FUZZ_MAX_DOC_B) {
+                    memmove(&doc[at + 1], &doc[at], length - at);
+                    doc[at] = c;
+                    length++;
+                }
+
+                break;
+            default:
+                // Delete a byte
+                if (length > 0) {
+                    memmove(&doc[at], &doc[at + 1], length - at - 1);
+                    length--;
+                }
+        }
+    }
+
+    return length;
+}
+
+
+/**
+ * @brief Get the next number from a fixed-seed xorshift generator,
+ *        so failures can be reproduced.
+ *
+ * @returns The number.
+ */
+static uint32_t fuzz_random(void) {
+
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+
+/**
+ * @brief Time a typical settings response, fed in the chunks
+ *        the device reads a response body in.
+ */
+static void bench_throughput(void) {
+
+    const char* doc = "{\"status\":\"ok\",\"sample_period_ms\":30000,\"batch_size\":16,"
+                      "\"click_threshold\":1.5,\"brightness\":8,\"feature_window_ms\":10000,"
+                      "\"temp_filters\":5,\"accel_filters\":0,\"firmware\":{\"latest\":\"3.1.1\"}}";
+    uint32_t length = (uint32_t)strlen(doc);
+
+    uint32_t splits[FUZZ_MAX_DOC_B / HTTP_BODY_CHUNK_SIZE_B + 1];
+    uint32_t split_count = 0;
+    for (uint32_t offset = HTTP_BODY_CHUNK_SIZE_B ; offset < length ; offset += HTTP_BODY_CHUNK_SIZE_B) splits[split_count++] = offset;
+
+    uint64_t runs = 0;
+    uint64_t start = host_time_ns();
+    uint64_t elapsed = 0;
+    ParseResult result;
+    do {
+        for (uint32_t i = 0 ; i < 1000 ; ++i) parse_document((const uint8_t*)doc, length, splits, split_count, &result);
+        runs += 1000;
+        elapsed = host_time_ns() - start;
+    } while (elapsed < BENCH_MIN_TIME_NS);
+
+    if (!result.is_valid || result.changes != 7) fail("benchmark document", (const uint8_t*)doc, length);
+    printf("Throughput: %u-byte settings update in %.0f ns, %.1f MB/s\n",
+           length, (double)elapsed / (double)runs, (double)(runs * length) * 1000.0 / (double)elapsed);
+}
+
+
+/**
+ * @brief Report a failed check.
+ *
+ * @param what:   The check.
+ * @param doc:    The document that failed it.
+ * @param length: The number of bytes in the document.
+ */
+static void fail(const char* what, const uint8_t* doc, uint32_t length) {
+
+    failures++;
+    printf("FAIL %s: \"", what);
+    for (uint32_t i = 0 ; i < length ; ++i) {
+        if (doc[i] >= 0x20 && doc[i] < 0x7F && doc[i] != '"' && doc[i] != '\\') {
+            putchar(doc[i]);
+        } else {
+            printf("\\x%02X", doc[i]);
+        }
+    }
+
+    printf("\"\n");
+}
@@ -0,0 +1,394 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * Checks that readings survive `pack.c` exactly, and that the sensor
+ * drivers' integer conversions agree with floating-point ones: the
+ * MCP9808 driver's original formula, and the LIS3DH datasheet's
+ * sensitivities.
+ *
+ * The drivers run against register files that stand in for the sensors.
+ */
+
+
+/*
+ * CONSTANTS
+ */
+#define     SERIES_LENGTH               512
+#define     SERIES_TICK_STEP_MS         2000
+#define     PACK_SEED                   0x9E3779B9
+
+// The MCP9808 driver's read-failure marker, which a real reading can't be told apart from
+#define     MCP9808_FAILURE_BITS        0x0630
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void     check_varints(void);
+static void     check_series(void);
+static void     check_truncation(void);
+static void     check_mcp9808(void);
+static void     check_lis3dh(void);
+static uint8_t* sensor_regs(uint8_t addr, uint8_t* reg);
+static uint32_t pack_random(void);
+static void     fail(const char* what, int64_t value);
+
+
+/*
+ * GLOBALS
+ */
+static uint32_t failures = 0;
+static uint32_t rng_state = PACK_SEED;
+
+// Register files for the sensors, written by the tests and the drivers
+static uint8_t mcp9808_regs[8][2];
+static uint8_t lis3dh_regs[0x40];
+
+// When non-zero, reads fail after transferring this many bytes
+static uint16_t partial_read_length = 0;
+
+
+int main(int argc, char* argv[]) {
+
+    (void)argc;
+    (void)argv;
+
+    check_varints();
+    check_series();
+    check_truncation();
+    check_mcp9808();
+    check_lis3dh();
+
+    if (failures > 0) {
+        printf("FAILED: %u checks\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
+
+
+/**
+ * @brief Round-trip single values, including the extremes, and check
+ *        the encoded lengths.
+ */
+static void check_varints(void) {
+
+    static const int32_t values[] = { 0, 1, -1, 63, -64, 64, -65, 8191, -8192, 8192,
+                                      INT16_MAX, INT16_MIN, INT32_MAX, INT32_MIN, INT32_MAX - 1, INT32_MIN + 1 };
+    uint8_t data[PACK_MAX_VARINT_B * 2 * sizeof(values) / sizeof(values[0])];
+    PackBuffer buffer;
+    pack_init(&buffer, data, sizeof(data));
+
+    for (uint32_t i = 0 ; i < sizeof(values) / sizeof(values[0]) ; ++i) {
+        uint32_t mark = buffer.length;
+        pack_int(&buffer, values[i]);
+        uint32_t zigzag = pack_zigzag(values[i]);
+        uint32_t expected_length = 1;
+        while (expected_length < PACK_MAX_VARINT_B && zigzag >= (1UL << (7 * expected_length))) expected_length++;
+        if (buffer.length - mark != expected_length) fail("varint length", values[i]);
+        if (unpack_zigzag(zigzag) != values[i]) fail("zig-zag round trip", values[i]);
+        pack_uint(&buffer, (uint32_t)values[i]);
+    }
+
+    if (buffer.overflow) fail("varint buffer overflow", buffer.length);
+
+    PackReader reader;
+    unpack_init(&reader, data, buffer.length);
+    for (uint32_t i = 0 ; i < sizeof(values) / sizeof(values[0]) ; ++i) {
+        int32_t value = 0;
+        uint32_t raw = 0;
+        if (!unpack_int(&reader, &value) || value != values[i]) fail("unpack_int", values[i]);
+        if (!unpack_uint(&reader, &raw) || raw != (uint32_t)values[i]) fail("unpack_uint", values[i]);
+    }
+
+    uint32_t extra = 0;
+    if (unpack_uint(&reader, &extra)) fail("read past the end", reader.offset);
+
+    // A full buffer flags the overflow rather than writing past its end
+    pack_init(&buffer, data, 3);
+    pack_uint(&buffer, UINT32_MAX);
+    if (!buffer.overflow || buffer.length > 3) fail("overflow not flagged", buffer.length);
+
+    printf("Varints: %zu values\n", sizeof(values) / sizeof(values[0]));
+}
+
+
+/**
+ * @brief Pack a series of readings the way `http_send_samples()` does,
+ *        decode it, and check that every reading comes back exactly.
+ */
+static void check_series(void) {
+
+    TelemetrySample samples[SERIES_LENGTH];
+    uint32_t tick = 0xFFFF0000;
+    int16_t temp = 23 * 16;
+    for (uint32_t i = 0 ; i < SERIES_LENGTH ; ++i) {
+        // Ticks wrap part-way through, and every tenth reading jumps
+        tick += SERIES_TICK_STEP_MS + pack_random() % 50;
+        temp += (int16_t)(pack_random() % 5) - 2;
+        if (i % 10 == 9) temp = (int16_t)((int32_t)(pack_random() % 8192) - 4096);
+        samples[i].tick = tick;
+        samples[i].temp = temp;
+    }
+
+    uint8_t data[SERIES_LENGTH * 2 * PACK_MAX_VARINT_B];
+    PackBuffer buffer;
+    pack_init(&buffer, data, sizeof(data));
+    int32_t last_tick = 0;
+    int32_t last_temp = 0;
+    for (uint32_t i = 0 ; i < SERIES_LENGTH ; ++i) {
+        pack_delta(&buffer, (int32_t)samples[i].tick, &last_tick);
+        pack_delta(&buffer, samples[i].temp, &last_temp);
+    }
+
+    PackReader reader;
+    unpack_init(&reader, data, buffer.length);
+    last_tick = 0;
+    last_temp = 0;
+    for (uint32_t i = 0 ; i < SERIES_LENGTH ; ++i) {
+        int32_t decoded_tick = 0;
+        int32_t decoded_temp = 0;
+        if (!unpack_delta(&reader, &decoded_tick, &last_tick) || (uint32_t)decoded_tick != samples[i].tick) fail("series tick", i);
+        if (!unpack_delta(&reader, &decoded_temp, &last_temp) || decoded_temp != samples[i].temp) fail("series temperature", i);
+        if (MCP9808_raw_to_millicelsius((int16_t)decoded_temp) != MCP9808_raw_to_millicelsius(samples[i].temp)) fail("series conversion", i);
+    }
+
+    if (reader.offset != buffer.length) fail("series not fully decoded", reader.offset);
+
+    printf("Series: %u readings packed in %u bytes, %.2f bytes per reading\n",
+           SERIES_LENGTH, buffer.length, (double)buffer.length / SERIES_LENGTH);
+}
+
+
+/**
+ * @brief Check that truncated and over-long streams are rejected
+ *        without being read past their ends.
+ */
+static void check_truncation(void) {
+
+    uint8_t data[PACK_MAX_VARINT_B + 1];
+    PackBuffer buffer;
+    pack_init(&buffer, data, sizeof(data));
+    pack_uint(&buffer, UINT32_MAX);
+
+    for (uint32_t length = 0 ; length < buffer.length ; ++length) {
+        // Copy to an exact-size allocation so the sanitizers see any overread
+        uint8_t* copy = malloc(length + 1);
+        memcpy(copy, data, length);
+        PackReader reader;
+        unpack_init(&reader, copy, length);
+        uint32_t value = 0;
+        if (unpack_uint(&reader, &value)) fail("truncated varint accepted", length);
+        free(copy);
+    }
+
+    // Six continuation bytes are more than 32 bits
+    uint8_t long_data[PACK_MAX_VARINT_B + 1];
+    memset(long_data, 0x80, sizeof(long_data));
+    PackReader reader;
+    unpack_init(&reader, long_data, sizeof(long_data));
+    uint32_t value = 0;
+    if (unpack_uint(&reader, &value)) fail("over-long varint accepted", sizeof(long_data));
+}
+
+
+/**
+ * @brief Read every ambient temperature register value through the
+ *        driver, and compare the result with the driver's original
+ *        floating-point conversion.
+ */
+static void check_mcp9808(void) {
+
+    uint32_t checked = 0;
+    for (uint32_t bits = 0 ; bits <= 0xFFFF ; ++bits) {
+        if (bits == MCP9808_FAILURE_BITS) continue;
+
+        mcp9808_regs[MCP9808_REG_AMBIENT_TEMP][0] = (uint8_t)(bits >> 8);
+        mcp9808_regs[MCP9808_REG_AMBIENT_TEMP][1] = (uint8_t)bits;
+        int16_t temp_raw = 0;
+        if (MCP9808_read_raw(&temp_raw) != HAL_OK) {
+            fail("MCP9808 read", bits);
+            continue;
+        }
+
+        // The driver's conversion before readings were kept raw
+        double celsius = (bits & 0x0FFF) / 16.0;
+        if (bits & 0x1000) celsius -= 256.0;
+
+        int32_t millicelsius = MCP9808_raw_to_millicelsius(temp_raw);
+        if (fabs(celsius * 1000.0 - millicelsius) > 0.5) fail("MCP9808 conversion", bits);
+
+        // And the reading must pack to, and back from, what was read
+        uint8_t data[PACK_MAX_VARINT_B];
+        PackBuffer buffer;
+        pack_init(&buffer, data, sizeof(data));
+        pack_int(&buffer, temp_raw);
+        PackReader reader;
+        unpack_init(&reader, data, buffer.length);
+        int32_t decoded = 0;
+        if (!unpack_int(&reader, &decoded) || MCP9808_raw_to_millicelsius((int16_t)decoded) != millicelsius) fail("MCP9808 packed reading", bits);
+        checked++;
+    }
+
+    // A read that fails part way must fail, whatever it transferred
+    for (partial_read_length = 1 ; partial_read_length <= 2 ; ++partial_read_length) {
+        mcp9808_regs[MCP9808_REG_AMBIENT_TEMP][0] = 0x01;
+        mcp9808_regs[MCP9808_REG_AMBIENT_TEMP][1] = 0x71;
+        int16_t temp_raw = 0;
+        if (MCP9808_read_raw(&temp_raw) == HAL_OK) fail("MCP9808 partial read accepted", partial_read_length);
+    }
+
+    partial_read_length = 0;
+    printf("MCP9808: %u register values\n", checked);
+}
+
+
+/**
+ * @brief For every mode and range, convert every count, and compare
+ *        the result with the datasheet's sensitivity applied in double
+ *        precision, and with the driver's own `float` conversion.
+ */
+static void check_lis3dh(void) {
+
+    // LIS3DH datasheet, table 4: bits of resolution, and mG per digit by range
+    static const uint8_t modes[3] = { LIS3DH_MODE_NORMAL, LIS3DH_MODE_LOW_POWER, LIS3DH_MODE_HIGH_RESOLUTION };
+    static const uint8_t bits[3] = { 10, 8, 12 };
+    static const uint8_t ranges[4] = { 2, 4, 8, 16 };
+    static const double sensitivity[3][4] = {
+        {  4.0,  8.0, 16.0,  48.0 },
+        { 16.0, 32.0, 64.0, 192.0 },
+        {  1.0,  2.0,  4.0,  12.0 }
+    };
+
+    for (uint32_t m = 0 ; m < 3 ; ++m) {
+        LIS3DH_set_mode(modes[m]);
+        for (uint32_t r = 0 ; r < 4 ; ++r) {
+            if (LIS3DH_set_range(ranges[r]) != ranges[r]) fail("LIS3DH range", ranges[r]);
+
+            for (int32_t count = INT16_MIN ; count <= INT16_MAX ; ++count) {
+                // Counts are left-justified: the low bits are unused
+                double digits = floor(count / (double)(1 << (16 - bits[m])));
+                double expected_mg = digits * sensitivity[m][r];
+                int32_t mg = LIS3DH_raw_to_mg((int16_t)count);
+                if ((double)mg != expected_mg) fail("LIS3DH mG", count);
+
+                float g = LIS3DH_raw_to_g((int16_t)count);
+                if (fabs((double)g * 1000.0 - expected_mg) > fabs(expected_mg) * 1e-6) fail("LIS3DH G", count);
+            }
+        }
+    }
+
+    // The driver reads counts little-endian, sign included
+    LIS3DH_set_mode(LIS3DH_MODE_NORMAL);
+    LIS3DH_set_range(2);
+    static const int16_t axes[3] = { -32768, 1234, -1 };
+    for (uint32_t i = 0 ; i < 3 ; ++i) {
+        lis3dh_regs[LIS3DH_OUT_X_L + 2 * i] = (uint8_t)axes[i];
+        lis3dh_regs[LIS3DH_OUT_X_L + 2 * i + 1] = (uint8_t)((uint16_t)axes[i] >> 8);
+    }
+
+    AccelRaw raw;
+    LIS3DH_get_accel_raw(&raw);
+    if (raw.x != axes[0] || raw.y != axes[1] || raw.z != axes[2]) fail("LIS3DH counts", raw.x);
+
+    printf("LIS3DH: 3 modes, 4 ranges, 65536 counts each\n");
+}
+
+
+/**
+ * @brief Find a sensor's register file.
+ *
+ * @param addr: The sensor's I2C address.
+ * @param reg:  The register, and its auto-increment flag. Set to just the register.
+ *
+ * @returns The register, or NULL if there is no sensor at the address.
+ */
+static uint8_t* sensor_regs(uint8_t addr, uint8_t* reg) {
+
+    if (addr == MCP9808_ADDR && *reg < 8) return mcp9808_regs[*reg];
+    if (addr == LIS3DH_ADDR) {
+        *reg &= ~LIS3DH_AUTO_INCREMENT;
+        if (*reg < sizeof(lis3dh_regs)) return &lis3dh_regs[*reg];
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Stand-ins for `i2c.c`, backed by the register files
+ */
+bool I2C_begin_batch(uint8_t addr, uint32_t timeout_ms) {
+
+    (void)addr;
+    (void)timeout_ms;
+    return true;
+}
+
+
+void I2C_end_batch(void) {
+
+}
+
+
+HAL_StatusTypeDef I2C_read_regs(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t length, uint32_t timeout_ms) {
+
+    (void)timeout_ms;
+    uint8_t* regs = sensor_regs(addr, &reg);
+    if (regs == NULL) return HAL_ERROR;
+    if (partial_read_length > 0 && partial_read_length <= length) {
+        memcpy(data, regs, partial_read_length);
+        return HAL_ERROR;
+    }
+
+    memcpy(data, regs, length);
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef I2C_write_regs(uint8_t addr, uint8_t reg, const uint8_t* data, uint16_t length, uint32_t timeout_ms) {
+
+    (void)timeout_ms;
+    uint8_t* regs = sensor_regs(addr, &reg);
+    if (regs == NULL) return HAL_ERROR;
+    memcpy(regs, data, length);
+    return HAL_OK;
+}
+
+
+/**
+ * @brief Get the next number from a fixed-seed xorshift generator.
+ *
+ * @returns The number.
+ */
+static uint32_t pack_random(void) {
+
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+
+/**
+ * @brief Report a failed check.
+ *
+ * @param what:  The check.
+ * @param value: The value that failed it.
+ */
+static void fail(const char* what, int64_t value) {
+
+    failures++;
+    if (failures <= 20) printf("FAIL %s: %lld\n", what, (long long)value);
+}
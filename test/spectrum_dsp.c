@@ -0,0 +1,23 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+
+
+/*
+ * `spectrum.c` built for the Cortex-M33's DSP extension, so that
+ * `spectrum_test.c` can compare its bins with the C path's. Its helpers
+ * run on the host models of the intrinsics in `stubs/stm32u5xx_hal.h`.
+ * The public functions are renamed so both builds link together
+ */
+#define     __ARM_FEATURE_DSP           1
+#define     spectrum_start              spectrum_dsp_start
+#define     spectrum_add_samples        spectrum_dsp_add_samples
+#define     spectrum_latest             spectrum_dsp_latest
+#define     spectrum_fft_q15            spectrum_dsp_fft_q15
+
+#include "spectrum.c"
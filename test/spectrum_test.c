@@ -0,0 +1,310 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+#include "host_stubs.h"
+
+
+/*
+ * Checks `spectrum_fft_q15()` against a double-precision DFT, scaled
+ * by 1/SPECTRUM_FFT_SIZE as the FFT's output is, and reports its error
+ * and the time each takes. Every transform is also run on the build
+ * of `spectrum.c` for the DSP extension, in `spectrum_dsp.c`, whose
+ * bins must match the C path's bit for bit. Last, a tone is passed
+ * through both builds' full analysis, which must find the same peak,
+ * at the tone's frequency and amplitude.
+ */
+
+
+/*
+ * CONSTANTS
+ */
+#define     RANDOM_CASES                200
+#define     RANDOM_SEED                 0x2545F491
+
+// The FFT rounds down at each of its stages, so its bins may be a few
+// LSBs from the exact DFT's. This is the most allowed, in either part
+#define     MAX_ERROR_LSB               6.0
+
+#define     TONE_RATE_HZ                100
+#define     TONE_FREQUENCY_HZ           12.5
+#define     TONE_AMPLITUDE              8000
+#define     TONE_OFFSET                 16384
+
+#define     BENCH_MIN_TIME_NS           50000000ULL
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static void     check_transform(const char* name, const uint32_t* input);
+static void     check_random_cases(void);
+static void     check_tone(void);
+static void     reference_dft(const uint32_t* input, double* re, double* im);
+static void     bench(void);
+static uint32_t random_q15(uint32_t bits);
+static uint32_t random_complex(void);
+static void     fail(const char* what, const char* name, double value);
+
+void            spectrum_dsp_start(uint8_t axis, uint32_t rate_hz);
+uint32_t        spectrum_dsp_add_samples(const AccelRaw* samples, uint32_t count);
+bool            spectrum_dsp_latest(SpectrumResult* result);
+void            spectrum_dsp_fft_q15(uint32_t* data);
+
+
+/*
+ * GLOBALS
+ */
+static uint32_t failures = 0;
+static uint32_t random_state = RANDOM_SEED;
+
+// Error across every transform checked
+static double worst_error = 0.0;
+static double signal_power = 0.0;
+static double error_power = 0.0;
+
+
+int main(int argc, char* argv[]) {
+
+    (void)argc;
+    (void)argv;
+
+    // An impulse, which spreads evenly across the bins
+    uint32_t input[SPECTRUM_FFT_SIZE] = { 0 };
+    input[0] = 16384;
+    check_transform("impulse", input);
+
+    // A full-scale cosine, centred on a bin
+    for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) {
+        int32_t value = (int32_t)lround(32767.0 * cos(2.0 * M_PI * 10.0 * i / SPECTRUM_FFT_SIZE));
+        input[i] = (uint32_t)(uint16_t)value;
+    }
+
+    check_transform("cosine", input);
+    check_random_cases();
+
+    printf("FFT of %u points against a double-precision DFT: max error %.2f LSB, SNR %.1f dB\n",
+           SPECTRUM_FFT_SIZE, worst_error, 10.0 * log10(signal_power / error_power));
+
+    check_tone();
+    bench();
+
+    if (failures > 0) {
+        printf("FAILED: %u checks\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}
+
+
+/**
+ * @brief Transform a frame with both builds, and compare the bins with
+ *        each other and with the exact DFT's.
+ *
+ * @param name:  The frame, for the report.
+ * @param input: The frame, as packed Q15 complex values.
+ */
+static void check_transform(const char* name, const uint32_t* input) {
+
+    uint32_t bins[SPECTRUM_FFT_SIZE];
+    uint32_t dsp_bins[SPECTRUM_FFT_SIZE];
+    memcpy(bins, input, sizeof(bins));
+    memcpy(dsp_bins, input, sizeof(dsp_bins));
+    spectrum_fft_q15(bins);
+    spectrum_dsp_fft_q15(dsp_bins);
+
+    if (memcmp(bins, dsp_bins, sizeof(bins)) != 0) fail("C and DSP bins differ", name, 0);
+
+    double re[SPECTRUM_FFT_SIZE];
+    double im[SPECTRUM_FFT_SIZE];
+    reference_dft(input, re, im);
+
+    double error = 0.0;
+    for (uint32_t k = 0 ; k < SPECTRUM_FFT_SIZE ; ++k) {
+        double error_re = (int16_t)(bins[k] & 0xFFFF) - re[k];
+        double error_im = (int16_t)(bins[k] >> 16) - im[k];
+        error = fmax(error, fmax(fabs(error_re), fabs(error_im)));
+        signal_power += re[k] * re[k] + im[k] * im[k];
+        error_power += error_re * error_re + error_im * error_im;
+    }
+
+    if (error > worst_error) worst_error = error;
+    if (error > MAX_ERROR_LSB) fail("error in LSB", name, error);
+}
+
+
+/**
+ * @brief Check random frames: real ones, normalized as
+ *        `spectrum_process_frame()` leaves them, then complex ones
+ *        with magnitudes up to 1.
+ */
+static void check_random_cases(void) {
+
+    uint32_t input[SPECTRUM_FFT_SIZE];
+    for (uint32_t n = 0 ; n < RANDOM_CASES ; ++n) {
+        bool is_complex = n >= RANDOM_CASES / 2;
+        for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) input[i] = is_complex ? random_complex() : random_q15(SPECTRUM_FRAME_BITS);
+
+        check_transform(is_complex ? "random complex" : "random real", input);
+    }
+}
+
+
+/**
+ * @brief Analyze a tone with both builds, and check the peak they find.
+ */
+static void check_tone(void) {
+
+    AccelRaw samples[SPECTRUM_FFT_SIZE] = { 0 };
+    for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) {
+        double phase = 2.0 * M_PI * TONE_FREQUENCY_HZ * i / TONE_RATE_HZ;
+        samples[i].z = (int16_t)lround(TONE_OFFSET + TONE_AMPLITUDE * sin(phase));
+    }
+
+    spectrum_start(SPECTRUM_AXIS_Z, TONE_RATE_HZ);
+    spectrum_dsp_start(SPECTRUM_AXIS_Z, TONE_RATE_HZ);
+    if (spectrum_add_samples(samples, SPECTRUM_FFT_SIZE) != 1) fail("frames analyzed", "tone", 0);
+    if (spectrum_dsp_add_samples(samples, SPECTRUM_FFT_SIZE) != 1) fail("frames analyzed", "tone, DSP", 0);
+
+    SpectrumResult result;
+    SpectrumResult dsp_result;
+    if (!spectrum_latest(&result) || !spectrum_dsp_latest(&dsp_result) || result.count == 0) {
+        fail("no peak", "tone", 0);
+        return;
+    }
+
+    if (result.count != dsp_result.count || memcmp(result.peaks, dsp_result.peaks, sizeof(result.peaks[0]) * result.count) != 0) {
+        fail("C and DSP peaks differ", "tone", 0);
+    }
+
+    // The tone is centred on a bin. Its amplitude in mG, at the
+    // driver's default ±2G normal-mode scale
+    double amplitude_mg = LIS3DH_raw_to_mg(TONE_AMPLITUDE);
+    const SpectrumPeak* peak = &result.peaks[0];
+    printf("Tone of %.2f Hz, %.0f mG: peak at %.2f Hz, %u mG\n",
+           TONE_FREQUENCY_HZ, amplitude_mg, peak->frequency / 100.0, peak->amplitude_mg);
+    if (peak->frequency != (uint32_t)(TONE_FREQUENCY_HZ * 100)) fail("peak frequency", "tone", peak->frequency);
+    if (fabs(peak->amplitude_mg - amplitude_mg) > amplitude_mg * 0.02) fail("peak amplitude", "tone", peak->amplitude_mg);
+}
+
+
+/**
+ * @brief Compute the DFT of a frame in double precision, divided by
+ *        SPECTRUM_FFT_SIZE to match the FFT.
+ *
+ * @param input: The frame, as packed Q15 complex values.
+ * @param re:    Set to the bins' real parts.
+ * @param im:    Set to the bins' imaginary parts.
+ */
+static void reference_dft(const uint32_t* input, double* re, double* im) {
+
+    for (uint32_t k = 0 ; k < SPECTRUM_FFT_SIZE ; ++k) {
+        double sum_re = 0.0;
+        double sum_im = 0.0;
+        for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) {
+            double angle = -2.0 * M_PI * (double)((k * i) % SPECTRUM_FFT_SIZE) / SPECTRUM_FFT_SIZE;
+            double x_re = (int16_t)(input[i] & 0xFFFF);
+            double x_im = (int16_t)(input[i] >> 16);
+            sum_re += x_re * cos(angle) - x_im * sin(angle);
+            sum_im += x_re * sin(angle) + x_im * cos(angle);
+        }
+
+        re[k] = sum_re / SPECTRUM_FFT_SIZE;
+        im[k] = sum_im / SPECTRUM_FFT_SIZE;
+    }
+}
+
+
+/**
+ * @brief Time the FFT, and the reference DFT for scale.
+ *
+ * The DSP build's time isn't reported: on the host its intrinsics
+ * are C models, not single instructions.
+ */
+static void bench(void) {
+
+    uint32_t input[SPECTRUM_FFT_SIZE];
+    uint32_t bins[SPECTRUM_FFT_SIZE];
+    for (uint32_t i = 0 ; i < SPECTRUM_FFT_SIZE ; ++i) input[i] = random_q15(SPECTRUM_FRAME_BITS);
+
+    uint64_t elapsed = 0;
+    uint64_t runs = 0;
+    while (elapsed < BENCH_MIN_TIME_NS) {
+        memcpy(bins, input, sizeof(bins));
+        uint64_t start = host_time_ns();
+        spectrum_fft_q15(bins);
+        elapsed += host_time_ns() - start;
+        runs++;
+    }
+
+    double fft_ns = (double)elapsed / (double)runs;
+
+    double re[SPECTRUM_FFT_SIZE];
+    double im[SPECTRUM_FFT_SIZE];
+    elapsed = 0;
+    runs = 0;
+    while (elapsed < BENCH_MIN_TIME_NS) {
+        uint64_t start = host_time_ns();
+        reference_dft(input, re, im);
+        elapsed += host_time_ns() - start;
+        runs++;
+    }
+
+    printf("FFT: %.0f ns per transform; double-precision DFT: %.0f ns\n", fft_ns, (double)elapsed / (double)runs);
+}
+
+
+/**
+ * @brief Make a random Q15 value, as a packed halfword.
+ *
+ * @param bits: The bits of magnitude, up to 15.
+ *
+ * @returns The value in the low halfword.
+ */
+static uint32_t random_q15(uint32_t bits) {
+
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+
+    int32_t limit = (1 << bits) - 1;
+    int32_t value = (int32_t)(random_state % (uint32_t)(2 * limit + 1)) - limit;
+    return (uint32_t)(uint16_t)value;
+}
+
+
+/**
+ * @brief Make a random packed Q15 complex value, of magnitude up to 1.
+ *
+ * @returns The value, real part low.
+ */
+static uint32_t random_complex(void) {
+
+    while (true) {
+        uint32_t value = random_q15(15) | (random_q15(15) << 16);
+        double re = (int16_t)(value & 0xFFFF);
+        double im = (int16_t)(value >> 16);
+        if (re * re + im * im <= 32767.0 * 32767.0) return value;
+    }
+}
+
+
+/**
+ * @brief Report a failed check.
+ *
+ * @param what:  The check.
+ * @param name:  The case that failed it.
+ * @param value: The value that failed it.
+ */
+static void fail(const char* what, const char* name, double value) {
+
+    failures++;
+    printf("FAIL %s, %s: %.2f\n", what, name, value);
+}
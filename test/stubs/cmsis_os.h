@@ -0,0 +1,86 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _STUB_CMSIS_OS_H_
+#define _STUB_CMSIS_OS_H_
+
+
+/*
+ * Just enough of CMSIS-RTOS v2 for the App sources
+ * to build for the host. See `host_stubs.c`
+ */
+#include <stdint.h>
+
+
+/*
+ * STRUCTURES
+ */
+typedef void*   osThreadId_t;
+typedef void*   osMutexId_t;
+
+typedef enum {
+    osOK            =  0,
+    osErrorTimeout  = -2,
+    osErrorResource = -3
+} osStatus_t;
+
+typedef enum {
+    osKernelInactive =  0,
+    osKernelReady    =  1,
+    osKernelRunning  =  2,
+    osKernelLocked   =  3
+} osKernelState_t;
+
+typedef struct {
+    const char* name;
+    uint32_t    attr_bits;
+    void*       cb_mem;
+    uint32_t    cb_size;
+} osMutexAttr_t;
+
+
+/*
+ * CONSTANTS
+ */
+// From `FreeRTOSConfig.h`
+#define     configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY    5
+
+#define     osMutexRecursive        0x00000001
+#define     osMutexPrioInherit      0x00000002
+#define     osFlagsWaitAny          0x00000000
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+osThreadId_t    osThreadGetId(void);
+uint32_t        osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags);
+uint32_t        osThreadFlagsClear(uint32_t flags);
+uint32_t        osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout);
+
+osKernelState_t osKernelGetState(void);
+int32_t         osKernelLock(void);
+int32_t         osKernelUnlock(void);
+
+osMutexId_t     osMutexNew(const osMutexAttr_t* attr);
+osStatus_t      osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout);
+osStatus_t      osMutexRelease(osMutexId_t mutex_id);
+osThreadId_t    osMutexGetOwner(osMutexId_t mutex_id);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _STUB_CMSIS_OS_H_
@@ -0,0 +1,255 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include <time.h>
+#include "main.h"
+
+
+/*
+ * Host stand-ins for the device services the App sources call.
+ * Logging is discarded; time comes from the host's monotonic clock
+ */
+
+
+/*
+ * CONSTANTS
+ */
+#define     HOST_THREAD                 ((osThreadId_t)1)
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    osThreadId_t    owner;
+    uint32_t        count;
+    bool            is_recursive;
+} HostMutex;            // Record for a mutex and the thread holding it
+
+
+/*
+ * GLOBALS
+ */
+osKernelState_t host_kernel_state = osKernelInactive;
+void (*host_wait_hook)(void) = NULL;
+osThreadId_t host_thread = HOST_THREAD;
+
+GPIO_TypeDef host_gpio_a, host_gpio_b;
+I2C_TypeDef host_i2c1;
+DWT_Type host_dwt;
+CoreDebug_Type host_core_debug;
+uint32_t SystemCoreClock = 160000000;
+
+static uint32_t thread_flags = 0;
+static uint32_t kernel_lock_depth = 0;
+
+
+/**
+ * @brief Discard a log message.
+ *
+ * @param format_string: Message with printf-style formatting.
+ * @param ...:           Optional additional arguments.
+ */
+void server_log(char* format_string, ...) {
+    
+    (void)format_string;
+}
+
+
+/**
+ * @brief Discard an error message.
+ *
+ * @param format_string: Message with printf-style formatting.
+ * @param ...:           Optional additional arguments.
+ */
+void server_error(char* format_string, ...) {
+    
+    (void)format_string;
+}
+
+
+/**
+ * @brief Get the milliseconds since an arbitrary point.
+ *
+ * @returns The host's monotonic clock, in ms.
+ */
+uint32_t HAL_GetTick(void) {
+    
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+
+/**
+ * @brief Get the nanoseconds since an arbitrary point, for benchmarks.
+ *
+ * @returns The host's monotonic clock, in ns.
+ */
+uint64_t host_time_ns(void) {
+    
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+
+/**
+ * @brief Stop on an unrecoverable error.
+ *
+ * @param err_code: The error's code.
+ */
+void report_and_assert(uint16_t err_code) {
+    
+    fprintf(stderr, "report_and_assert(%u)\n", err_code);
+    abort();
+}
+
+
+/*
+ * The RTOS runs one thread at a time, which is never pre-empted. A test
+ * switches threads by setting `host_thread`. Interrupts are raised only
+ * while a thread waits: see `host_wait_hook`
+ */
+osThreadId_t osThreadGetId(void) {
+    
+    return host_thread;
+}
+
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags) {
+    
+    if (thread_id == host_thread) thread_flags |= flags;
+    return thread_flags;
+}
+
+
+uint32_t osThreadFlagsClear(uint32_t flags) {
+    
+    uint32_t previous = thread_flags;
+    thread_flags &= ~flags;
+    return previous;
+}
+
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    
+    (void)options;
+    (void)timeout;
+    if ((thread_flags & flags) == 0 && host_wait_hook != NULL) host_wait_hook();
+    
+    uint32_t set = thread_flags & flags;
+    thread_flags &= ~set;
+    return set != 0 ? set : (uint32_t)osErrorTimeout;
+}
+
+
+osKernelState_t osKernelGetState(void) {
+    
+    if (host_kernel_state == osKernelRunning && kernel_lock_depth > 0) return osKernelLocked;
+    return host_kernel_state;
+}
+
+
+int32_t osKernelLock(void) {
+    
+    return kernel_lock_depth++ > 0 ? 1 : 0;
+}
+
+
+int32_t osKernelUnlock(void) {
+    
+    return kernel_lock_depth > 0 && --kernel_lock_depth > 0 ? 1 : 0;
+}
+
+
+osMutexId_t osMutexNew(const osMutexAttr_t* attr) {
+    
+    HostMutex* mutex = calloc(1, sizeof(HostMutex));
+    if (mutex != NULL) mutex->is_recursive = attr != NULL && (attr->attr_bits & osMutexRecursive) != 0;
+    return mutex;
+}
+
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout) {
+    
+    (void)timeout;
+    HostMutex* mutex = (HostMutex*)mutex_id;
+    if (mutex->count > 0 && (mutex->owner != host_thread || !mutex->is_recursive)) return osErrorResource;
+    mutex->owner = host_thread;
+    mutex->count++;
+    return osOK;
+}
+
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id) {
+    
+    HostMutex* mutex = (HostMutex*)mutex_id;
+    if (mutex->count == 0 || mutex->owner != host_thread) return osErrorResource;
+    if (--mutex->count == 0) mutex->owner = NULL;
+    return osOK;
+}
+
+
+osThreadId_t osMutexGetOwner(osMutexId_t mutex_id) {
+    
+    return ((HostMutex*)mutex_id)->owner;
+}
+
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt_priority, uint32_t sub_priority) {
+    
+    (void)irq;
+    (void)preempt_priority;
+    (void)sub_priority;
+}
+
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq) {
+    
+    (void)irq;
+}
+
+
+void NVIC_EnableIRQ(IRQn_Type irq) {
+    
+    (void)irq;
+}
+
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq) {
+    
+    (void)irq;
+}
+
+
+void HAL_Delay(uint32_t delay_ms) {
+    
+    (void)delay_ms;
+}
+
+
+void HAL_GPIO_Init(GPIO_TypeDef* bank, GPIO_InitTypeDef* init) {
+    
+    (void)bank;
+    (void)init;
+}
+
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef* bank, uint16_t pin) {
+    
+    (void)bank;
+    (void)pin;
+}
+
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef* init) {
+    
+    (void)init;
+    return HAL_OK;
+}
@@ -0,0 +1,45 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _HOST_STUBS_H_
+#define _HOST_STUBS_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+uint64_t    host_time_ns(void);
+
+
+/*
+ * GLOBALS
+ */
+// The state `osKernelGetState()` reports while the kernel isn't locked.
+// Defaults to osKernelInactive
+extern osKernelState_t  host_kernel_state;
+
+// Called when the host thread waits for thread flags, so a model
+// can raise the interrupts that would set them
+extern void             (*host_wait_hook)(void);
+
+// The running thread, as `osThreadGetId()` reports it. Set it to
+// another value to act as another thread, eg. to hold a mutex
+extern osThreadId_t     host_thread;
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _HOST_STUBS_H_
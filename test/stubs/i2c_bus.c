@@ -0,0 +1,374 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+#include "host_stubs.h"
+#include "i2c_bus.h"
+
+
+/*
+ * A host model of the I2C bus, behind the HAL calls `i2c.c` makes.
+ *
+ * Devices are register files. A register address selects `reg_width`
+ * bytes; a transfer of more steps on through the registers, unless
+ * the device has an `increment_flag` and the address lacks it. A raw
+ * write sets the register pointer from its first byte, and writes
+ * the rest; a raw read reads from the pointer.
+ *
+ * Every call is counted, as are the STOP-delimited transactions it
+ * puts on the bus, and the transactions the same traffic would cost
+ * `unbatched`: without a repeated START, so a register read is an
+ * address write then a read, and, for devices whose drivers used to
+ * write one register at a time (`has_single_writes`), without bursts.
+ *
+ * The `_IT` calls complete when the calling task waits for them, as
+ * if the I2C interrupt had fired.
+ */
+
+
+/*
+ * CONSTANTS
+ */
+#define     OP_TRANSMIT     0
+#define     OP_RECEIVE      1
+#define     OP_MEM_WRITE    2
+#define     OP_MEM_READ     3
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    bool                is_pending;
+    uint8_t             op;
+    I2C_HandleTypeDef*  i2c;
+    uint16_t            addr;
+    uint16_t            reg;
+    uint8_t*            data;
+    uint16_t            length;
+} PendingTransfer;      // Record for an `_IT` transfer awaiting its interrupt
+
+
+/*
+ * STATIC PROTOTYPES
+ */
+static HAL_StatusTypeDef    i2c_bus_transfer(uint8_t op, uint16_t addr, uint16_t reg, uint8_t* data, uint16_t length);
+static HAL_StatusTypeDef    i2c_bus_start(uint8_t op, I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint8_t* data, uint16_t length);
+static I2CBusDevice*        i2c_bus_find(uint16_t addr);
+static uint8_t*             i2c_bus_reg(I2CBusDevice* device, uint8_t reg, uint32_t byte);
+
+
+/*
+ * GLOBALS
+ */
+// Defined in `main.c` on the device
+I2C_HandleTypeDef   i2c;
+bool                use_i2c = true;
+
+static I2CBusDevice     devices[I2C_BUS_MAX_DEVICES];
+static uint32_t         device_count = 0;
+static I2CBusCounts     totals = { 0 };
+static uint32_t         failures_to_inject = 0;
+static PendingTransfer  pending = { 0 };
+
+
+/**
+ * @brief Add a device to the bus.
+ *
+ * @param addr:              The device's 7-bit address.
+ * @param reg_width:         The number of bytes in each register.
+ * @param increment_flag:    The register address bit that enables multi-register
+ *                           transfers, or 0 if they are always enabled.
+ * @param has_single_writes: Whether the device's driver used to write its
+ *                           registers one per transaction.
+ *
+ * @returns The device's record, so the caller can set its registers.
+ */
+I2CBusDevice* i2c_bus_add(uint8_t addr, uint8_t reg_width, uint8_t increment_flag, bool has_single_writes) {
+    
+    if (device_count == I2C_BUS_MAX_DEVICES) return NULL;
+    
+    I2CBusDevice* device = &devices[device_count++];
+    memset(device, 0, sizeof(I2CBusDevice));
+    device->addr = addr;
+    device->reg_width = reg_width;
+    device->increment_flag = increment_flag;
+    device->has_single_writes = has_single_writes;
+    host_wait_hook = i2c_bus_interrupt;
+    return device;
+}
+
+
+/**
+ * @brief Zero the traffic counters.
+ */
+void i2c_bus_reset_counts(void) {
+    
+    memset(&totals, 0, sizeof(totals));
+    for (uint32_t i = 0 ; i < device_count ; ++i) memset(&devices[i].counts, 0, sizeof(I2CBusCounts));
+}
+
+
+/**
+ * @brief Get the traffic counters for the whole bus.
+ *
+ * @param data: Set to the counters.
+ */
+void i2c_bus_get_counts(I2CBusCounts* data) {
+    
+    *data = totals;
+}
+
+
+/**
+ * @brief Make the next transfers fail, as if the device didn't acknowledge.
+ *
+ * @param count: The number of transfers to fail.
+ */
+void i2c_bus_fail_next(uint32_t count) {
+    
+    failures_to_inject = count;
+}
+
+
+/**
+ * @brief Carry out a transfer and count it.
+ *
+ * @returns The HAL status of the transfer.
+ */
+static HAL_StatusTypeDef i2c_bus_transfer(uint8_t op, uint16_t addr, uint16_t reg, uint8_t* data, uint16_t length) {
+    
+    I2CBusDevice* device = i2c_bus_find(addr);
+    I2CBusCounts* counts[2] = { &totals, device != NULL ? &device->counts : NULL };
+    for (uint32_t i = 0 ; i < 2 && counts[i] != NULL ; ++i) {
+        counts[i]->hal_calls++;
+        counts[i]->transactions++;
+        if (op == OP_MEM_READ) {
+            counts[i]->unbatched += 2;
+            counts[i]->bytes += 3 + length;
+        } else if (op == OP_MEM_WRITE) {
+            counts[i]->unbatched += device != NULL && device->has_single_writes ? (length + device->reg_width - 1) / device->reg_width : 1;
+            counts[i]->bytes += 2 + length;
+        } else {
+            counts[i]->unbatched++;
+            counts[i]->bytes += 1 + length;
+        }
+    }
+    
+    if (failures_to_inject > 0) {
+        failures_to_inject--;
+        return HAL_ERROR;
+    }
+    
+    if (device == NULL) return HAL_ERROR;
+    
+    uint8_t start = device->pointer;
+    if (op == OP_MEM_READ || op == OP_MEM_WRITE) {
+        start = (uint8_t)reg;
+    } else if (op == OP_TRANSMIT && length > 0) {
+        start = data[0];
+        data++;
+        length--;
+    }
+    
+    device->pointer = start;
+    for (uint32_t i = 0 ; i < length ; ++i) {
+        uint8_t* byte = i2c_bus_reg(device, start, i);
+        if (op == OP_RECEIVE || op == OP_MEM_READ) {
+            data[i] = byte != NULL ? *byte : 0xFF;
+        } else if (byte != NULL) {
+            *byte = data[i];
+        }
+    }
+    
+    return HAL_OK;
+}
+
+
+/**
+ * @brief Queue an `_IT` transfer for the next wait.
+ *
+ * @returns HAL_OK, or HAL_BUSY if a transfer is already under way.
+ */
+static HAL_StatusTypeDef i2c_bus_start(uint8_t op, I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint8_t* data, uint16_t length) {
+    
+    if (pending.is_pending) return HAL_BUSY;
+    pending = (PendingTransfer){ true, op, i2c, addr, reg, data, length };
+    return HAL_OK;
+}
+
+
+/**
+ * @brief Complete `_IT` transfers and call back, as the I2C interrupt would.
+ */
+void i2c_bus_interrupt(void) {
+    
+    while (pending.is_pending) {
+        PendingTransfer transfer = pending;
+        pending.is_pending = false;
+        
+        if (i2c_bus_transfer(transfer.op, transfer.addr, transfer.reg, transfer.data, transfer.length) != HAL_OK) {
+            HAL_I2C_ErrorCallback(transfer.i2c);
+        } else if (transfer.op == OP_TRANSMIT) {
+            HAL_I2C_MasterTxCpltCallback(transfer.i2c);
+        } else if (transfer.op == OP_RECEIVE) {
+            HAL_I2C_MasterRxCpltCallback(transfer.i2c);
+        } else if (transfer.op == OP_MEM_WRITE) {
+            HAL_I2C_MemTxCpltCallback(transfer.i2c);
+        } else {
+            HAL_I2C_MemRxCpltCallback(transfer.i2c);
+        }
+    }
+}
+
+
+/**
+ * @brief Find the device at an address.
+ *
+ * @param addr: The address as the HAL takes it: shifted left by one.
+ *
+ * @returns The device, or NULL if there isn't one.
+ */
+static I2CBusDevice* i2c_bus_find(uint16_t addr) {
+    
+    for (uint32_t i = 0 ; i < device_count ; ++i) {
+        if (devices[i].addr == addr >> 1) return &devices[i];
+    }
+    
+    return NULL;
+}
+
+
+/**
+ * @brief Find the byte a transfer reaches.
+ *
+ * @param device: The device.
+ * @param reg:    The register address the transfer started at.
+ * @param byte:   The offset into the transfer.
+ *
+ * @returns The byte, or NULL if it's off the end of the register file.
+ */
+static uint8_t* i2c_bus_reg(I2CBusDevice* device, uint8_t reg, uint32_t byte) {
+    
+    uint32_t index = reg;
+    if (device->increment_flag != 0) {
+        // Without the flag, the transfer stays on the one register
+        index &= ~device->increment_flag;
+        if ((reg & device->increment_flag) == 0) byte %= device->reg_width;
+    }
+    
+    index = index * device->reg_width + byte;
+    return index < I2C_BUS_REG_COUNT ? &device->regs[index] : NULL;
+}
+
+
+/*
+ * The HAL calls
+ */
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* i2c) {
+    
+    (void)i2c;
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* i2c) {
+    
+    (void)i2c;
+    pending.is_pending = false;
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* i2c, uint16_t addr, uint32_t trials, uint32_t timeout_ms) {
+    
+    (void)i2c;
+    (void)trials;
+    (void)timeout_ms;
+    return i2c_bus_find(addr) != NULL ? HAL_OK : HAL_ERROR;
+}
+
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* i2c) {
+    
+    (void)i2c;
+    return 0;
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef* i2c, uint16_t addr, uint8_t* data, uint16_t length, uint32_t timeout_ms) {
+    
+    (void)i2c;
+    (void)timeout_ms;
+    return i2c_bus_transfer(OP_TRANSMIT, addr, 0, data, length);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef* i2c, uint16_t addr, uint8_t* data, uint16_t length, uint32_t timeout_ms) {
+    
+    (void)i2c;
+    (void)timeout_ms;
+    return i2c_bus_transfer(OP_RECEIVE, addr, 0, data, length);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t* data, uint16_t length, uint32_t timeout_ms) {
+    
+    (void)i2c;
+    (void)reg_size;
+    (void)timeout_ms;
+    return i2c_bus_transfer(OP_MEM_WRITE, addr, reg, data, length);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t* data, uint16_t length, uint32_t timeout_ms) {
+    
+    (void)i2c;
+    (void)reg_size;
+    (void)timeout_ms;
+    return i2c_bus_transfer(OP_MEM_READ, addr, reg, data, length);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef* i2c, uint16_t addr, uint8_t* data, uint16_t length) {
+    
+    return i2c_bus_start(OP_TRANSMIT, i2c, addr, 0, data, length);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef* i2c, uint16_t addr, uint8_t* data, uint16_t length) {
+    
+    return i2c_bus_start(OP_RECEIVE, i2c, addr, 0, data, length);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t* data, uint16_t length) {
+    
+    (void)reg_size;
+    return i2c_bus_start(OP_MEM_WRITE, i2c, addr, reg, data, length);
+}
+
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t* data, uint16_t length) {
+    
+    (void)reg_size;
+    return i2c_bus_start(OP_MEM_READ, i2c, addr, reg, data, length);
+}
+
+
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef* i2c) {
+    
+    (void)i2c;
+    i2c_bus_interrupt();
+}
+
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef* i2c) {
+    
+    (void)i2c;
+}
@@ -0,0 +1,61 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _I2C_BUS_H_
+#define _I2C_BUS_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     I2C_BUS_MAX_DEVICES         4
+#define     I2C_BUS_REG_COUNT           256
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    transactions;
+    uint32_t    unbatched;
+    uint32_t    hal_calls;
+    uint32_t    bytes;
+} I2CBusCounts;         // Record for bus traffic, overall or for one device
+
+typedef struct {
+    uint8_t         addr;
+    uint8_t         reg_width;
+    uint8_t         increment_flag;
+    bool            has_single_writes;
+    uint8_t         pointer;
+    uint8_t         regs[I2C_BUS_REG_COUNT];
+    I2CBusCounts    counts;
+} I2CBusDevice;         // Record for a modelled device
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+I2CBusDevice*   i2c_bus_add(uint8_t addr, uint8_t reg_width, uint8_t increment_flag, bool has_single_writes);
+void            i2c_bus_reset_counts(void);
+void            i2c_bus_get_counts(I2CBusCounts* data);
+void            i2c_bus_fail_next(uint32_t count);
+void            i2c_bus_interrupt(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _I2C_BUS_H_
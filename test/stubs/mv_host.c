@@ -0,0 +1,132 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#include "main.h"
+#include "mv_host.h"
+
+
+/*
+ * A host model of Microvisor's network, notification and HTTP channel
+ * calls. The network is always up, and the server answers each request
+ * with the status code set in its record and an empty body. Responses
+ * are posted as notifications, and `mv_host_deliver()` runs the
+ * notification ISR, as Microvisor would, and then the HTTP service.
+ */
+
+
+/*
+ * GLOBALS
+ */
+static struct MvNotification* notification_buffer = NULL;
+static uint32_t notification_count = 0;
+static uint32_t notification_index = 0;
+static MvChannelHandle open_channel = 0;
+static MvHostServer server = { .status_code = 200 };
+
+
+/**
+ * @brief Get the model server's record.
+ *
+ * @returns A pointer to the record.
+ */
+MvHostServer* mv_host_server(void) {
+    
+    return &server;
+}
+
+
+/**
+ * @brief Deliver any posted notifications, and let the
+ *        HTTP service handle them.
+ */
+void mv_host_deliver(void) {
+    
+    TIM8_BRK_IRQHandler();
+    http_service();
+}
+
+
+enum MvStatus mvSetupNotifications(const struct MvNotificationSetup* setup, MvNotificationHandle* handle) {
+    
+    notification_buffer = setup->buffer;
+    notification_count = setup->buffer_size / sizeof(struct MvNotification);
+    notification_index = 0;
+    *handle = 1;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvOpenChannel(const struct MvOpenChannelParams* params, MvChannelHandle* handle) {
+    
+    (void)params;
+    open_channel = 2;
+    *handle = open_channel;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvCloseChannel(MvChannelHandle* handle) {
+    
+    if (*handle != open_channel) return MV_STATUS_INVALIDHANDLE;
+    open_channel = 0;
+    *handle = 0;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvSendHttpRequest(MvChannelHandle handle, const struct MvHttpRequest* request) {
+    
+    if (handle != open_channel || handle == 0) return MV_STATUS_INVALIDHANDLE;
+    
+    server.requests++;
+    server.body_length = request->body.length < MV_HOST_MAX_BODY_B ? request->body.length : MV_HOST_MAX_BODY_B;
+    memcpy(server.body, request->body.data, server.body_length);
+    
+    // Post the response's arrival
+    if (notification_buffer != NULL) {
+        struct MvNotification* notification = &notification_buffer[notification_index];
+        notification->microseconds = (uint64_t)HAL_GetTick() * 1000;
+        notification->event_type = MV_EVENTTYPE_CHANNELDATAREADABLE;
+        notification->tag = USER_TAG_HTTP_OPEN_CHANNEL;
+        notification_index = (notification_index + 1) % notification_count;
+    }
+    
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvReadHttpResponseData(MvChannelHandle handle, struct MvHttpResponseData* data) {
+    
+    if (handle != open_channel || handle == 0) return MV_STATUS_INVALIDHANDLE;
+    data->result = MV_HTTPRESULT_OK;
+    data->status_code = server.status_code;
+    data->num_headers = 0;
+    data->body_length = 0;
+    return MV_STATUS_OKAY;
+}
+
+
+enum MvStatus mvReadHttpResponseBody(MvChannelHandle handle, uint32_t offset, uint8_t* buffer, uint32_t length) {
+    
+    (void)offset;
+    (void)buffer;
+    (void)length;
+    return handle == open_channel && handle != 0 ? MV_STATUS_OKAY : MV_STATUS_INVALIDHANDLE;
+}
+
+
+MvNetworkHandle net_get_handle(void) {
+    
+    return 1;
+}
+
+
+bool net_is_connected(void) {
+    
+    return true;
+}
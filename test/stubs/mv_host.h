@@ -0,0 +1,50 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _MV_HOST_H_
+#define _MV_HOST_H_
+
+
+/*
+ * CONSTANTS
+ */
+#define     MV_HOST_MAX_BODY_B          1024
+
+
+/*
+ * STRUCTURES
+ */
+typedef struct {
+    uint32_t    requests;
+    uint32_t    body_length;
+    uint8_t     body[MV_HOST_MAX_BODY_B];
+    uint32_t    status_code;
+} MvHostServer;         // Record for the model server's view of the last request
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+MvHostServer*   mv_host_server(void);
+void            mv_host_deliver(void);
+
+// The HTTP notification ISR, in `http.c`
+void            TIM8_BRK_IRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _MV_HOST_H_
@@ -0,0 +1,126 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _STUB_MV_SYSCALLS_H_
+#define _STUB_MV_SYSCALLS_H_
+
+
+/*
+ * Just enough of the Microvisor system calls for the App
+ * sources to build for the host. See `host_stubs.c`
+ */
+#include <stdint.h>
+
+
+/*
+ * STRUCTURES
+ */
+typedef uint32_t    MvNetworkHandle;
+typedef uint32_t    MvNotificationHandle;
+typedef uint32_t    MvChannelHandle;
+
+enum MvStatus {
+    MV_STATUS_OKAY = 0,
+    MV_STATUS_INVALIDHANDLE = 4,
+    MV_STATUS_UNAVAILABLE = 11,
+    MV_STATUS_CHANNELCLOSED = 17,
+    MV_STATUS_RATELIMITED = 31
+};
+
+enum MvEventType {
+    MV_EVENTTYPE_CHANNELDATAREADABLE = 1,
+    MV_EVENTTYPE_CHANNELNOTCONNECTED = 3
+};
+
+enum MvChannelType {
+    MV_CHANNELTYPE_HTTP = 3
+};
+
+enum MvHttpResult {
+    MV_HTTPRESULT_OK = 0,
+    MV_HTTPRESULT_REQUESTFAILED = 2
+};
+
+struct MvNotification {
+    uint64_t    microseconds;
+    uint32_t    event_type;
+    uint32_t    tag;
+};
+
+struct MvNotificationSetup {
+    uint32_t                irq;
+    struct MvNotification*  buffer;
+    uint32_t                buffer_size;
+};
+
+struct MvSizedString {
+    const uint8_t*  data;
+    uint32_t        length;
+};
+
+struct MvHttpHeader {
+    const uint8_t*  data;
+    uint32_t        length;
+};
+
+struct MvOpenChannelParams {
+    uint32_t version;
+    union {
+        struct {
+            MvNotificationHandle    notification_handle;
+            uint32_t                notification_tag;
+            MvNetworkHandle         network_handle;
+            uint8_t*                receive_buffer;
+            uint32_t                receive_buffer_len;
+            uint8_t*                send_buffer;
+            uint32_t                send_buffer_len;
+            enum MvChannelType      channel_type;
+            struct MvSizedString    endpoint;
+        } v1;
+    };
+};
+
+struct MvHttpRequest {
+    struct MvSizedString        method;
+    struct MvSizedString        url;
+    uint32_t                    num_headers;
+    const struct MvHttpHeader*  headers;
+    struct MvSizedString        body;
+    uint32_t                    timeout_ms;
+};
+
+struct MvHttpResponseData {
+    enum MvHttpResult   result;
+    uint32_t            status_code;
+    uint32_t            num_headers;
+    uint32_t            body_length;
+};
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+enum MvStatus   mvSetupNotifications(const struct MvNotificationSetup* setup, MvNotificationHandle* handle);
+enum MvStatus   mvOpenChannel(const struct MvOpenChannelParams* params, MvChannelHandle* handle);
+enum MvStatus   mvCloseChannel(MvChannelHandle* handle);
+enum MvStatus   mvSendHttpRequest(MvChannelHandle handle, const struct MvHttpRequest* request);
+enum MvStatus   mvReadHttpResponseData(MvChannelHandle handle, struct MvHttpResponseData* data);
+enum MvStatus   mvReadHttpResponseBody(MvChannelHandle handle, uint32_t offset, uint8_t* buffer, uint32_t length);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _STUB_MV_SYSCALLS_H_
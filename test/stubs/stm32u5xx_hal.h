@@ -0,0 +1,217 @@
+/**
+ *
+ * Microvisor IoT Device Demo
+ *
+ * Copyright © 2023, KORE Wireless
+ * Licence: MIT
+ *
+ */
+#ifndef _STUB_HAL_H_
+#define _STUB_HAL_H_
+
+
+/*
+ * Just enough of the STM32U5 HAL for the App sources
+ * to build for the host. See `host_stubs.c`
+ */
+#include <stdint.h>
+
+
+/*
+ * STRUCTURES
+ */
+typedef enum {
+    HAL_OK      = 0x00,
+    HAL_ERROR   = 0x01,
+    HAL_BUSY    = 0x02,
+    HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+typedef enum {
+    I2C1_EV_IRQn  = 55,
+    I2C1_ER_IRQn  = 56,
+    TIM8_BRK_IRQn = 43
+} IRQn_Type;
+
+typedef struct {
+    uint32_t    id;
+} GPIO_TypeDef, I2C_TypeDef;
+
+typedef struct {
+    uint32_t    Pin;
+    uint32_t    Mode;
+    uint32_t    Pull;
+    uint32_t    Speed;
+    uint32_t    Alternate;
+} GPIO_InitTypeDef;
+
+typedef struct {
+    uint32_t    PeriphClockSelection;
+    uint32_t    I2c1ClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+typedef struct {
+    uint32_t    Timing;
+    uint32_t    AddressingMode;
+    uint32_t    DualAddressMode;
+    uint32_t    OwnAddress1;
+    uint32_t    OwnAddress2;
+    uint32_t    OwnAddress2Masks;
+    uint32_t    GeneralCallMode;
+    uint32_t    NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef struct {
+    I2C_TypeDef*    Instance;
+    I2C_InitTypeDef Init;
+} I2C_HandleTypeDef;
+
+typedef struct {
+    uint32_t    CTRL;
+    uint32_t    CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    uint32_t    DEMCR;
+} CoreDebug_Type;
+
+
+/*
+ * CONSTANTS
+ */
+extern GPIO_TypeDef host_gpio_a, host_gpio_b;
+extern I2C_TypeDef host_i2c1;
+
+// The cycle counter doesn't count on the host, so sub-ms timings read 0
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_core_debug;
+extern uint32_t SystemCoreClock;
+
+#define     GPIOA                       (&host_gpio_a)
+#define     GPIOB                       (&host_gpio_b)
+#define     I2C1                        (&host_i2c1)
+#define     DWT                         (&host_dwt)
+#define     CoreDebug                   (&host_core_debug)
+
+#define     DWT_CTRL_CYCCNTENA_Msk      0x00000001
+#define     CoreDebug_DEMCR_TRCENA_Msk  0x01000000
+
+#define     GPIO_PIN_5                  0x0020
+#define     GPIO_PIN_6                  0x0040
+#define     GPIO_PIN_9                  0x0200
+#define     GPIO_MODE_AF_OD             0x12
+#define     GPIO_NOPULL                 0x00
+#define     GPIO_SPEED_FREQ_LOW         0x00
+#define     GPIO_AF4_I2C1               0x04
+
+#define     RCC_PERIPHCLK_I2C1          0x0040
+#define     RCC_I2C1CLKSOURCE_PCLK1     0x00
+
+#define     I2C_ADDRESSINGMODE_7BIT     0x01
+#define     I2C_DUALADDRESS_DISABLE     0x00
+#define     I2C_OA2_NOMASK              0x00
+#define     I2C_GENERALCALL_DISABLE     0x00
+#define     I2C_NOSTRETCH_ENABLE        0x00020000
+#define     I2C_MEMADD_SIZE_8BIT        0x01
+
+
+/*
+ * MACROS
+ */
+#define     __DMB()                 __sync_synchronize()
+#define     __disable_irq()
+#define     __enable_irq()
+#define     __NOP()
+#define     __HAL_RCC_GPIOB_CLK_ENABLE()
+#define     __HAL_RCC_I2C1_CLK_ENABLE()
+
+
+/*
+ * DSP EXTENSION INTRINSICS
+ *
+ * Models of the instructions `spectrum.c` uses when built for the DSP
+ * extension, as the Armv8-M Architecture Reference Manual defines them.
+ * Halfwords are signed, the low one first. Results wrap; none of these
+ * saturate
+ */
+static inline uint32_t __SHADD16(uint32_t a, uint32_t b) {
+
+    int32_t lo = ((int32_t)(int16_t)a + (int16_t)b) >> 1;
+    int32_t hi = ((int32_t)(int16_t)(a >> 16) + (int16_t)(b >> 16)) >> 1;
+    return (uint32_t)(uint16_t)lo | ((uint32_t)(uint16_t)hi << 16);
+}
+
+static inline uint32_t __SHSUB16(uint32_t a, uint32_t b) {
+
+    int32_t lo = ((int32_t)(int16_t)a - (int16_t)b) >> 1;
+    int32_t hi = ((int32_t)(int16_t)(a >> 16) - (int16_t)(b >> 16)) >> 1;
+    return (uint32_t)(uint16_t)lo | ((uint32_t)(uint16_t)hi << 16);
+}
+
+// lo * lo - hi * hi
+static inline uint32_t __SMUSD(uint32_t a, uint32_t b) {
+
+    return (uint32_t)((int64_t)(int16_t)a * (int16_t)b - (int64_t)(int16_t)(a >> 16) * (int16_t)(b >> 16));
+}
+
+// lo * hi + hi * lo
+static inline uint32_t __SMUADX(uint32_t a, uint32_t b) {
+
+    return (uint32_t)((int64_t)(int16_t)a * (int16_t)(b >> 16) + (int64_t)(int16_t)(a >> 16) * (int16_t)b);
+}
+
+// lo * lo + hi * hi
+static inline uint32_t __SMUAD(uint32_t a, uint32_t b) {
+
+    return (uint32_t)((int64_t)(int16_t)a * (int16_t)b + (int64_t)(int16_t)(a >> 16) * (int16_t)(b >> 16));
+}
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * PROTOTYPES
+ */
+uint32_t    HAL_GetTick(void);
+void        HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt_priority, uint32_t sub_priority);
+void        NVIC_ClearPendingIRQ(IRQn_Type irq);
+void        NVIC_EnableIRQ(IRQn_Type irq);
+void        HAL_NVIC_EnableIRQ(IRQn_Type irq);
+void        HAL_Delay(uint32_t delay_ms);
+void        HAL_GPIO_Init(GPIO_TypeDef* bank, GPIO_InitTypeDef* init);
+void        HAL_GPIO_TogglePin(GPIO_TypeDef* bank, uint16_t pin);
+HAL_StatusTypeDef   HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef* init);
+
+// Implemented by the bus model, `i2c_bus.c`
+HAL_StatusTypeDef   HAL_I2C_Init(I2C_HandleTypeDef* i2c);
+HAL_StatusTypeDef   HAL_I2C_DeInit(I2C_HandleTypeDef* i2c);
+HAL_StatusTypeDef   HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* i2c, uint16_t addr, uint32_t trials, uint32_t timeout_ms);
+uint32_t            HAL_I2C_GetError(I2C_HandleTypeDef* i2c);
+HAL_StatusTypeDef   HAL_I2C_Master_Transmit(I2C_HandleTypeDef* i2c, uint16_t addr, uint8_t* data, uint16_t length, uint32_t timeout_ms);
+HAL_StatusTypeDef   HAL_I2C_Master_Receive(I2C_HandleTypeDef* i2c, uint16_t addr, uint8_t* data, uint16_t length, uint32_t timeout_ms);
+HAL_StatusTypeDef   HAL_I2C_Mem_Write(I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t* data, uint16_t length, uint32_t timeout_ms);
+HAL_StatusTypeDef   HAL_I2C_Mem_Read(I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t* data, uint16_t length, uint32_t timeout_ms);
+HAL_StatusTypeDef   HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef* i2c, uint16_t addr, uint8_t* data, uint16_t length);
+HAL_StatusTypeDef   HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef* i2c, uint16_t addr, uint8_t* data, uint16_t length);
+HAL_StatusTypeDef   HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t* data, uint16_t length);
+HAL_StatusTypeDef   HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef* i2c, uint16_t addr, uint16_t reg, uint16_t reg_size, uint8_t* data, uint16_t length);
+void                HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef* i2c);
+
+// HAL callbacks, implemented in `i2c.c`
+void                HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* i2c);
+void                HAL_I2C_ErrorCallback(I2C_HandleTypeDef* i2c);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif      // _STUB_HAL_H_
@@ -16,23 +16,33 @@ set(CMAKE_SIZE arm-none-eabi-size CACHE FILEPATH "")
 set(CMAKE_C_COMPILER_WORKS ON)
 set(CMAKE_CXX_COMPILER_WORKS ON)
 
+# Set by ENABLE_HARDWARE_FPU in the root CMakeLists.txt
+if(ENABLE_HARDWARE_FPU)
+  set(FLOAT_ABI "hard")
+else()
+  set(FLOAT_ABI "soft")
+endif()
+
+# Assembly objects must carry the same float ABI attributes as the C ones, or they won't link
+set(CMAKE_ASM_FLAGS "-mcpu=cortex-m33 -mthumb -mfpu=fpv5-sp-d16 -mfloat-abi=${FLOAT_ABI}")
+
 set(CMAKE_C_FLAGS "-mcpu=cortex-m33 -std=gnu11 -g3 \
   -DUSE_CUSTOM_SYSTICK_HANDLER_IMPLEMENTATION -DUSE_HAL_DRIVER -DSTM32L552xx \
   -DSTM32U585xx -DDEBUG -DCMSIS_device_header=\\\"stm32u585xx.h\\\" \
-  -c -O0 -ffunction-sections -fdata-sections -Wall -fstack-usage \
-  -MMD -MP --specs=nano.specs -mfpu=fpv5-sp-d16 -mfloat-abi=soft -mthumb")
+  -c -O0 -ffunction-sections -fdata-sections -Wall -Wdouble-promotion -fstack-usage \
+  -MMD -MP --specs=nano.specs -mfpu=fpv5-sp-d16 -mfloat-abi=${FLOAT_ABI} -mthumb")
 
 set(CMAKE_C_LINK_FLAGS "-mcpu=cortex-m33 --specs=nosys.specs -Wl,--gc-sections -static \
-  -Wl,--start-group -lc -lm -Wl,--end-group -mfloat-abi=soft" CACHE INTERNAL "")
+  -Wl,--start-group -lc -lm -Wl,--end-group -mfpu=fpv5-sp-d16 -mfloat-abi=${FLOAT_ABI}" CACHE INTERNAL "")
 
 set(CMAKE_CXX_FLAGS "-mcpu=cortex-m33 -g3 \
   -DUSE_CUSTOM_SYSTICK_HANDLER_IMPLEMENTATION -DUSE_HAL_DRIVER -DSTM32L552xx \
   -DSTM32U585xx -DDEBUG -DCMSIS_device_header=\\\"stm32u585xx.h\\\" \
   -O0 -ffunction-sections -fdata-sections -Wall -fstack-usage \
-  -MMD -MP --specs=nano.specs -mfpu=fpv5-sp-d16 -mfloat-abi=soft -mthumb")
+  -MMD -MP --specs=nano.specs -mfpu=fpv5-sp-d16 -mfloat-abi=${FLOAT_ABI} -mthumb")
 
 set(CMAKE_CXX_LINK_FLAGS "-mcpu=cortex-m33 --specs=nosys.specs -Wl,--gc-sections -static \
-  -Wl,--start-group -lc -lm -Wl,--end-group -mfloat-abi=soft -u _printf_float" CACHE INTERNAL "")
+  -Wl,--start-group -lc -lm -Wl,--end-group -mfpu=fpv5-sp-d16 -mfloat-abi=${FLOAT_ABI} -u _printf_float" CACHE INTERNAL "")
 
 set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
 set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)